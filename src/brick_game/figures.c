@@ -35,3 +35,37 @@ Block lFigure[5][5] = {{{0}, {0}, {0}, {0}, {0}},
                        {{0}, {0}, {1}, {0}, {0}},
                        {{0}, {0}, {1}, {1}, {0}},
                        {{0}, {0}, {0}, {0}, {0}}};
+
+/* Rotation r of a template is r counterclockwise quarter turns of its 5x5
+ * frame, each clipped to its bounding box. skirt[c] is the lowest row of the
+ * box holding a block in column c. */
+const Shape tetShapes[7][4] = {
+    {{2, 0, 1, 4, {0x1, 0x1, 0x1, 0x1}, {3}},
+     {0, 2, 4, 1, {0xF}, {0, 0, 0, 0}},
+     {2, 1, 1, 4, {0x1, 0x1, 0x1, 0x1}, {3}},
+     {1, 2, 4, 1, {0xF}, {0, 0, 0, 0}}},  // i
+    {{1, 1, 2, 2, {0x3, 0x3}, {1, 1}},
+     {1, 2, 2, 2, {0x3, 0x3}, {1, 1}},
+     {2, 2, 2, 2, {0x3, 0x3}, {1, 1}},
+     {2, 1, 2, 2, {0x3, 0x3}, {1, 1}}},  // o
+    {{1, 1, 3, 2, {0x2, 0x7}, {1, 1, 1}},
+     {1, 1, 2, 3, {0x2, 0x3, 0x2}, {1, 2}},
+     {1, 2, 3, 2, {0x7, 0x2}, {0, 1, 0}},
+     {2, 1, 2, 3, {0x1, 0x3, 0x1}, {2, 1}}},  // t
+    {{1, 2, 3, 2, {0x6, 0x3}, {1, 1, 0}},
+     {2, 1, 2, 3, {0x1, 0x3, 0x2}, {1, 2}},
+     {1, 1, 3, 2, {0x6, 0x3}, {1, 1, 0}},
+     {1, 1, 2, 3, {0x1, 0x3, 0x2}, {1, 2}}},  // s
+    {{1, 2, 3, 2, {0x3, 0x6}, {0, 1, 1}},
+     {2, 1, 2, 3, {0x2, 0x3, 0x1}, {2, 1}},
+     {1, 1, 3, 2, {0x3, 0x6}, {0, 1, 1}},
+     {1, 1, 2, 3, {0x2, 0x3, 0x1}, {2, 1}}},  // z
+    {{1, 1, 2, 3, {0x2, 0x2, 0x3}, {2, 2}},
+     {1, 2, 3, 2, {0x7, 0x4}, {0, 0, 1}},
+     {2, 1, 2, 3, {0x3, 0x1, 0x1}, {2, 0}},
+     {1, 1, 3, 2, {0x1, 0x7}, {1, 1, 1}}},  // j
+    {{2, 1, 2, 3, {0x1, 0x1, 0x3}, {2, 2}},
+     {1, 1, 3, 2, {0x4, 0x7}, {1, 1, 1}},
+     {1, 1, 2, 3, {0x3, 0x2, 0x2}, {0, 2}},
+     {1, 2, 3, 2, {0x7, 0x1}, {1, 0, 0}}},  // l
+};
@@ -9,4 +9,6 @@ extern Block sFigure[5][5];
 extern Block zFigure[5][5];
 extern Block jFigure[5][5];
 extern Block lFigure[5][5];
+
+extern const Shape tetShapes[7][4];
 #endif
\ No newline at end of file
@@ -1,102 +1,180 @@
+#include <string.h>
+
+#include "figures.h"
+#include "profile.h"
 #include "tetris.h"
 
-void userInput(UserAction_t action, bool hold) {
-  if (!hold) {
-    switch (action) {
-      case Left:
-        tetg->player->action = Left;
-        break;
-      case Right:
-        tetg->player->action = Right;
-        break;
-      case Up:
-        tetg->player->action = Up;
-        break;
-      case Down:
-        tetg->player->action = Down;
-        break;
-      case Start:
-        tetg->player->action = Start;
-        break;
-      case Pause:
-        tetg->player->action = Pause;
-        break;
-      case Terminate:
-        tetg->player->action = Terminate;
-        break;
-      default:
-        tetg->player->action = Action;
-        break;
-    }
+void userInput(Game *tetg, UserAction_t action, bool hold) {
+  Player *player = tetg->player;
+  if (hold || player->queued == INPUT_QUEUE_SIZE) return;
+  switch (action) {
+    case Left:
+    case Right:
+    case Up:
+    case Down:
+    case Start:
+    case Pause:
+    case Terminate:
+    case HardDrop: {
+      int tail = (player->head + player->queued) % INPUT_QUEUE_SIZE;
+      player->queue[tail] = (InputEvent){monotonicNs(), action};
+      player->queued++;
+    } break;
+    default:
+      break;
   }
 }
 
 void dropNewFigure(Game *tetg) {
   tetg->figure = createFigure(tetg);
-  Figure *figure = createFigure(tetg);
-  figure->x = tetg->field->width / 2 - figure->size / 2;
-  figure->y = 0;
-  int fnum = tetg->next;
-
-  for (int i = 0; i < figure->size; i++)
-    for (int j = 0; j < figure->size; j++)
-      figure->blocks[i][j].b =
-          tetg->figurest->blocks[fnum][i * figure->size + j].b;
-  if (tetg->figure != NULL) freeFigure(tetg->figure);
-  tetg->figure = figure;
-
-  fnum = rand() % tetg->figurest->count;  // update next fig
-  tetg->next = fnum;
+
+  tetg->next = nextFigureType(tetg);  // update next fig
+  emitEvent(tetg, EVENT_SPAWN, tetg->next);
+}
+
+void emitEvent(Game *tetg, int type, int32_t value) {
+  EventQueue *queue = tetg->events;
+  if (queue->count == EVENT_QUEUE_SIZE) {
+    queue->overflow = true;
+    return;
+  }
+  const Figure *figure = tetg->figure;
+  int tail = (queue->head + queue->count) % EVENT_QUEUE_SIZE;
+  queue->events[tail] = (GameEvent){(uint8_t)type, (uint8_t)figure->type,
+                                    (uint8_t)figure->rot, (int8_t)figure->x,
+                                    (int8_t)figure->y, value};
+  queue->count++;
+}
+
+int pollEvents(Game *tetg, GameEvent *out, int max) {
+  EventQueue *queue = tetg->events;
+  if (max <= 0) return 0;
+  if (queue->overflow) {  // the frontend missed something: start over
+    queue->head = queue->count = 0;
+    queue->overflow = false;
+    emitEvent(tetg, EVENT_RESET, 0);
+  }
+  int n = 0;
+  for (; n < max && queue->count > 0; n++) {
+    out[n] = queue->events[queue->head];
+    queue->head = (queue->head + 1) % EVENT_QUEUE_SIZE;
+    queue->count--;
+  }
+  return n;
 }
 
-GameInfo_t updateCurrentState() {
+GameInfo_t updateCurrentState(Game *tetg) {
   GameInfo_t game_info = {0};
+  uint64_t mark = profileStart(tetg->profile);
   calculate(tetg);
+  profileLap(tetg->profile, PHASE_SIMULATE, &mark);
 
   if (tetg->state != GAMEOVER) {
-    if (game_info.field != NULL)
-      freePrintField(game_info.field, tetg->field->height);
-    game_info.field = createPrintField(tetg->field->width, tetg->field->height);
-
-    if (game_info.next != NULL)
-      freeNextBlock(game_info.next, tetg->figurest->size);
+    game_info = exportCurrentState(tetg);
+    profileLap(tetg->profile, PHASE_EXPORT, &mark);
+  }
+  return game_info;
+}
 
-    game_info.next = createNextBlock(tetg->figurest->size);
+GameInfo_t exportCurrentState(Game *tetg) {
+  GameInfo_t game_info = {0};
+  tetg->buffer ^= 1;  // keep the previous frame intact for the frontend
+  game_info.field = tetg->print_field[tetg->buffer];
+  fillPrintField(tetg, game_info.field);
+  game_info.next = tetg->print_next[tetg->buffer];
+  fillNextBlock(tetg, game_info.next);
 
-    game_info.score = tetg->score;
-    game_info.high_score = tetg->high_score;
-    game_info.level = tetg->level;
-    game_info.speed = tetg->speed;
-    game_info.pause = tetg->pause;
-  }
+  game_info.score = tetg->score;
+  game_info.high_score = tetg->high_score;
+  game_info.level = tetg->level;
+  game_info.speed = tetg->speed;
+  game_info.pause = tetg->pause;
+  game_info.cleared_rows = tetg->cleared_rows;
+  tetg->cleared_rows = 0;
+  game_info.ghost_row = tetg->figure->y + figureShape(tetg->figure)->dy +
+                        dropDistance(tetg);
   return game_info;
 }
 
+GameView viewGame(const Game *tetg) {
+  const Field *field = tetg->field;
+  Figure next = {0, 0, tetg->next, 0};
+  GameView view = {0};
+  view.rows = field->rows;
+  view.cells = field->cells;
+  view.width = field->width;
+  view.height = field->height;
+  view.piece = *tetg->figure;
+  view.shape = figureShape(tetg->figure);
+  view.next_shape = figureShape(&next);
+  view.next = tetg->next;
+  view.ghost_row = view.piece.y + view.shape->dy + dropDistance(tetg);
+  view.score = tetg->score;
+  view.high_score = tetg->high_score;
+  view.level = tetg->level;
+  view.speed = tetg->speed;
+  view.pause = tetg->pause;
+  view.generation = tetg->generation;
+  return view;
+}
+
+int viewCell(const GameView *view, int y, int x) {
+  const Shape *shape = view->shape;
+  int sy = y - view->piece.y - shape->dy;
+  int sx = x - view->piece.x - shape->dx;
+  if (sy >= 0 && sy < shape->h && sx >= 0 && sx < shape->w &&
+      ((shape->rows[sy] >> sx) & 1))
+    return view->piece.type + 1;
+  return view->cells[y * view->width + x];
+}
+
 void calculate(Game *tetg) {
   if (tetg->ticks_left <= 0 && tetg->state != PAUSE && tetg->state != INIT)
     calcOne(tetg);  // to slower down 30 fps game
   if (tetg->state == GAMEOVER) return;
 
-  switch (tetg->player->action) {
+  applyAction(tetg);
+  tetg->ticks_left--;
+}
+
+/**
+ * Applies one action to the game.
+ */
+static void performAction(Game *tetg, int action) {
+  tetg->generation++;
+  switch (action) {
     case Right:
       if (tetg->pause) break;
       moveFigureRight(tetg);
-      if (collision(tetg)) moveFigureLeft(tetg);
+      if (collision(tetg))
+        moveFigureLeft(tetg);
+      else
+        emitEvent(tetg, EVENT_MOVE, 0);
       break;
     case Left:
       if (tetg->pause) break;
       moveFigureLeft(tetg);
-      if (collision(tetg)) moveFigureRight(tetg);
+      if (collision(tetg))
+        moveFigureRight(tetg);
+      else
+        emitEvent(tetg, EVENT_MOVE, 0);
       break;
     case Down:
       if (tetg->pause) break;
       moveFigureDown(tetg);
-      if (collision(tetg)) moveFigureUp(tetg);
+      if (collision(tetg))
+        moveFigureUp(tetg);
+      else
+        emitEvent(tetg, EVENT_MOVE, 0);
       break;
     case Up: {
       if (tetg->pause) break;
       handleRotation(tetg);
     } break;
+    case HardDrop:
+      if (tetg->pause) break;
+      hardDrop(tetg);
+      break;
     case Pause:
       if (tetg->pause) {
         tetg->pause = 0;
@@ -105,22 +183,39 @@ void calculate(Game *tetg) {
         tetg->pause = 1;
         tetg->state = PAUSE;
       }
+      emitEvent(tetg, EVENT_PAUSE, tetg->pause);
       break;
     case Terminate:
       tetg->state = GAMEOVER;
+      emitEvent(tetg, EVENT_GAMEOVER, 0);
       break;
     case Start:
+      if (tetg->pause) emitEvent(tetg, EVENT_PAUSE, 0);
       tetg->pause = 0;
       tetg->state = MOVING;
       break;
     default:
       break;
   }
+}
 
-  tetg->ticks_left--;
+void applyAction(Game *tetg) {
+  Player *player = tetg->player;
+  while (player->queued > 0 && tetg->state != GAMEOVER) {
+    InputEvent event = player->queue[player->head];
+    player->head = (player->head + 1) % INPUT_QUEUE_SIZE;
+    player->queued--;
+    player->action = event.action;
+    if (tetg->profile != NULL)
+      recordLatency(&tetg->profile->phases[PHASE_LATENCY],
+                    monotonicNs() - event.time_ns);
+    performAction(tetg, event.action);
+  }
 }
 
 void calcOne(Game *tetg) {
+  uint64_t mark = profileStart(tetg->profile);
+  tetg->generation++;
   tetg->ticks_left = tetg->ticks;
   moveFigureDown(tetg);
   tetg->state = MOVING;
@@ -128,13 +223,17 @@ void calcOne(Game *tetg) {
     moveFigureUp(tetg);
     plantFigure(tetg);
     countScore(tetg);
-    if (tetg->figure != NULL) freeFigure(tetg->figure);
     dropNewFigure(tetg);
+    tetg->pieces++;
     tetg->state = DROP;
     if (collision(tetg)) {
       tetg->state = GAMEOVER;
+      emitEvent(tetg, EVENT_GAMEOVER, 0);
     }
+  } else {
+    emitEvent(tetg, EVENT_MOVE, 0);
   }
+  profileLap(tetg->profile, PHASE_STEP, &mark);
 }
 
 void moveFigureDown(Game *tetg) { tetg->figure->y++; }
@@ -145,96 +244,226 @@ void moveFigureRight(Game *tetg) { tetg->figure->x++; }
 
 void moveFigureLeft(Game *tetg) { tetg->figure->x--; }
 
+/**
+ * Shifts a figure row mask to field column x. Returns 0 when any block of the
+ * row falls outside the field.
+ */
+static int placeRow(uint16_t bits, int x, uint16_t full, uint16_t *placed) {
+  uint32_t wide;
+  *placed = 0;
+  if (x <= -FIELD_MAX_WIDTH || x >= FIELD_MAX_WIDTH) return bits == 0;
+  if (x >= 0)
+    wide = (uint32_t)bits << x;
+  else {
+    if (bits & ((1u << -x) - 1)) return 0;
+    wide = bits >> -x;
+  }
+  if (wide & ~(uint32_t)full) return 0;
+  *placed = (uint16_t)wide;
+  return 1;
+}
+
+/**
+ * Checks that a shape whose bounding box starts at column x, row y lies
+ * inside the field on free cells only.
+ */
+static int shapeFits(const Field *field, const Shape *shape, int x, int y) {
+  for (int i = 0; i < shape->h; i++) {
+    uint16_t placed;
+    int fy = y + i;
+    if (fy < 0 || fy >= field->height ||
+        !placeRow(shape->rows[i], x, field->full, &placed) ||
+        (field->rows[fy] & placed))
+      return 0;
+  }
+  return 1;
+}
+
 int collision(Game *tetg) {
   Figure *figure = tetg->figure;
-  Field *field = tetg->field;
+  const Shape *shape = figureShape(figure);
 
-  for (int i = 0; i < figure->size; i++)
-    for (int j = 0; j < figure->size; j++) {
-      if (figure->blocks[i][j].b != 0) {
-        int fx = figure->x + j;
-        int fy = figure->y + i;
-        if (fx < 0 || fx >= field->width || fy < 0 || fy >= field->height) {
-          tetg->state = COLLISION;
-          return 1;
-        }
-        if (field->blocks[fy][fx].b != 0) {
-          tetg->state = COLLISION;
-          return 1;
-        }
-      }
-    }
+  if (!shapeFits(tetg->field, shape, figure->x + shape->dx,
+                 figure->y + shape->dy)) {
+    tetg->state = COLLISION;
+    return 1;
+  }
   return 0;
 }
 
+int dropDistance(const Game *tetg) {
+  const Figure *figure = tetg->figure;
+  const Field *field = tetg->field;
+  const Shape *shape = figureShape(figure);
+  int x = figure->x + shape->dx;
+  int y = figure->y + shape->dy;
+  int distance = field->height;
+
+  for (int c = 0; c < shape->w; c++) {
+    int col = x + c;
+    int d = -1;
+    if (col >= 0 && col < field->width)
+      d = field->height - field->heights[col] - 1 - (y + shape->skirt[c]);
+    if (d < 0) {  // under an overhang or off the field: probe instead
+      distance = 0;
+      while (shapeFits(field, shape, x, y + distance + 1)) distance++;
+      return distance;
+    }
+    if (d < distance) distance = d;
+  }
+  return distance;
+}
+
+void hardDrop(Game *tetg) {
+  int distance = dropDistance(tetg);
+  tetg->figure->y += distance;
+  if (distance > 0) emitEvent(tetg, EVENT_MOVE, 0);
+  calcOne(tetg);
+}
+
+/**
+ * Recomputes column heights by scanning down from the top until every
+ * column has met its highest block.
+ */
+static void recountHeights(Field *tfl) {
+  uint16_t open = tfl->full;
+  for (int j = 0; j < tfl->width; j++) tfl->heights[j] = 0;
+  for (int i = 0; i < tfl->height && open; i++) {
+    uint16_t hit = tfl->rows[i] & open;
+    open &= (uint16_t)~hit;
+    for (; hit; hit &= hit - 1)
+      tfl->heights[__builtin_ctz(hit)] = (uint8_t)(tfl->height - i);
+  }
+}
+
+/**
+ * Occupies the cells of bits in row y with piece id, keeping the row count
+ * and the column heights current.
+ */
+static void fillRow(Field *tfl, int y, uint16_t bits, uint8_t id) {
+  uint8_t *cells = tfl->cells + y * tfl->width;
+  bits &= (uint16_t)~tfl->rows[y];
+  tfl->rows[y] |= bits;
+  tfl->fill[y] += (uint8_t)__builtin_popcount(bits);
+  for (; bits; bits &= bits - 1) {
+    int j = __builtin_ctz(bits);
+    cells[j] = id;
+    if (tfl->heights[j] < tfl->height - y)
+      tfl->heights[j] = (uint8_t)(tfl->height - y);
+  }
+}
+
 int eraseLines(Game *tetg) {
   Field *tfl = tetg->field;
+  uint32_t cleared = 0;
   int count = 0;
+  int dst = tfl->height - 1;
   for (int i = tfl->height - 1; i >= 0; i--) {
-    while (lineFilled(i, tfl)) {
-      dropLine(i, tfl);
+    if (lineFilled(i, tfl)) {
+      if (i < 32) cleared |= 1u << i;
       count++;
+    } else {
+      if (dst != i) {  // rows below the lowest cleared one stay put
+        tfl->rows[dst] = tfl->rows[i];
+        tfl->fill[dst] = tfl->fill[i];
+        memcpy(tfl->cells + dst * tfl->width, tfl->cells + i * tfl->width,
+               tfl->width);
+      }
+      dst--;
     }
   }
+  if (count) memset(tfl->cells, 0, (size_t)(dst + 1) * tfl->width);
+  for (; dst >= 0; dst--) {
+    tfl->rows[dst] = 0;
+    tfl->fill[dst] = 0;
+  }
+  if (count) {
+    recountHeights(tfl);
+    emitEvent(tetg, EVENT_CLEAR, (int32_t)cleared);
+  }
+  tetg->cleared_rows |= cleared;
   return count;
 }
 
-int lineFilled(int i, Field *tfl) {
-  for (int j = 0; j < tfl->width; j++)
-    if (tfl->blocks[i][j].b == 0) return 0;
-  return 1;
-}
+int lineFilled(int i, Field *tfl) { return tfl->fill[i] == tfl->width; }
 
 void dropLine(int i, Field *tfl) {
-  if (i == 0)
-    for (int j = 0; j < tfl->width; j++) tfl->blocks[i][j].b = 0;
-  else {
-    for (int k = i; k > 0; k--)
-      for (int j = 0; j < tfl->width; j++)
-        tfl->blocks[k][j].b = tfl->blocks[k - 1][j].b;  // move line up
+  for (int k = i; k > 0; k--) {  // move line up
+    tfl->rows[k] = tfl->rows[k - 1];
+    tfl->fill[k] = tfl->fill[k - 1];
   }
+  memmove(tfl->cells + tfl->width, tfl->cells, (size_t)i * tfl->width);
+  tfl->rows[0] = 0;
+  tfl->fill[0] = 0;
+  memset(tfl->cells, 0, tfl->width);
+  recountHeights(tfl);
 }
 
-Figure *rotFigure(Game *tetg) {
-  Figure *figure = createFigure(tetg);
-  Figure *old_figure = tetg->figure;
-  figure->x = old_figure->x;
-  figure->y = old_figure->y;
-  int size = figure->size;
-
-  for (int i = 0; i < size; i++)
-    for (int j = 0; j < size; j++)
-      figure->blocks[i][j].b = old_figure->blocks[j][size - 1 - i].b;
-  return figure;
+void setBlock(Field *tfl, int y, int x, int b) {
+  if (b) {
+    fillRow(tfl, y, (uint16_t)(1u << x), (uint8_t)b);
+    tfl->cells[y * tfl->width + x] = (uint8_t)b;
+  } else if (getBlock(tfl, y, x)) {
+    tfl->rows[y] &= (uint16_t)~(1u << x);
+    tfl->fill[y]--;
+    tfl->cells[y * tfl->width + x] = 0;
+    recountHeights(tfl);
+  }
+}
+
+void recountField(Field *tfl) {
+  for (int i = 0; i < tfl->height; i++) {
+    uint8_t *cells = tfl->cells + i * tfl->width;
+    tfl->fill[i] = (uint8_t)__builtin_popcount(tfl->rows[i]);
+    for (int j = 0; j < tfl->width; j++)
+      if (!((tfl->rows[i] >> j) & 1))
+        cells[j] = 0;
+      else if (cells[j] == 0)
+        cells[j] = 1;
+  }
+  recountHeights(tfl);
+}
+
+int getBlock(const Field *tfl, int y, int x) {
+  return (tfl->rows[y] >> x) & 1;
+}
+
+const Shape *figureShape(const Figure *figure) {
+  return &tetShapes[figure->type][figure->rot];
+}
+
+void rotFigure(Game *tetg, int dir) {
+  tetg->figure->rot = (tetg->figure->rot + dir) & 3;
 }
 
 void handleRotation(Game *tetg) {
-  Figure *t = rotFigure(tetg);
-  Figure *told = tetg->figure;
-  tetg->figure = t;
-  if (collision(tetg)) {
-    tetg->figure = told;
-    freeFigure(t);
-  } else
-    freeFigure(told);
+  rotFigure(tetg, 1);
+  if (collision(tetg))
+    rotFigure(tetg, -1);
+  else
+    emitEvent(tetg, EVENT_ROTATE, 0);
 }
 
 void plantFigure(Game *tetg) {
   Figure *figure = tetg->figure;
-  for (int i = 0; i < figure->size; i++)
-    for (int j = 0; j < figure->size; j++)
-      if (figure->blocks[i][j].b != 0) {
-        int fx = figure->x + j;
-        int fy = figure->y + i;
-        if (fx >= 0 && fx < tetg->field->width && fy >= 0 &&
-            fy < tetg->field->height) {
-          tetg->field->blocks[fy][fx].b = figure->blocks[i][j].b;
-        }
-      }
+  Field *field = tetg->field;
+  const Shape *shape = figureShape(figure);
+  int x = figure->x + shape->dx;
+  for (int i = 0; i < shape->h; i++) {
+    int fy = figure->y + shape->dy + i;
+    if (fy < 0 || fy >= field->height) continue;
+    if (x <= -FIELD_MAX_WIDTH || x >= FIELD_MAX_WIDTH) continue;
+    uint32_t wide = x >= 0 ? (uint32_t)shape->rows[i] << x
+                           : (uint32_t)shape->rows[i] >> -x;
+    fillRow(field, fy, (uint16_t)(wide & field->full),
+            (uint8_t)(figure->type + 1));
+  }
+  emitEvent(tetg, EVENT_PLANT, 0);
 }
 
 void countScore(Game *tetg) {
   int erased_lines = eraseLines(tetg);
+  tetg->lines += erased_lines;
   switch (erased_lines) {
     case 0:
       break;
@@ -251,14 +480,14 @@ void countScore(Game *tetg) {
       tetg->score += 1500;
       break;
   }
-  if (tetg->score > tetg->high_score) {
-    tetg->high_score = tetg->score;
-    saveHighScore(tetg->high_score);
-  }
+  if (erased_lines) emitEvent(tetg, EVENT_SCORE, tetg->score);
+  if (tetg->score > tetg->high_score)
+    tetg->high_score = tetg->score;  // saved by the frontend at game end
 
   int new_level = tetg->score / 600 + 1;  // +1 чтобы начать с уровня 1
   if (new_level > tetg->level && new_level <= 10) {
     tetg->level = new_level;
     tetg->speed = new_level;
+    emitEvent(tetg, EVENT_LEVEL, new_level);
   }
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "handoff.h"
+
+#include <string.h>
+
+#define FRESH 4
+
+void initInputRing(InputRing *ring) {
+  atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+  atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+}
+
+int pushInput(InputRing *ring, UserAction_t action) {
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (tail - head == INPUT_RING_SIZE) return 0;
+  ring->slots[tail % INPUT_RING_SIZE] = (uint8_t)action;
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+int popInput(InputRing *ring, UserAction_t *action) {
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head == tail) return 0;
+  *action = (UserAction_t)ring->slots[head % INPUT_RING_SIZE];
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  return 1;
+}
+
+TripleBuffer *createTripleBuffer(int width, int height, int size) {
+  size_t slot = (size_t)height * width + (size_t)size * size +
+                (size_t)(height + size) * sizeof(uint8_t *);
+  size_t total = sizeof(TripleBuffer) + 3 * slot + 16 * _Alignof(max_align_t);
+  Arena arena = {calloc(1, total), 0, total};
+  if (arena.base == NULL) return NULL;
+
+  TripleBuffer *buffer =
+      (TripleBuffer *)arenaAlloc(&arena, sizeof(TripleBuffer));
+  for (int k = 0; k < 3; k++) {
+    GameInfo_t *info = &buffer->slots[k];
+    info->field = createPrintField(&arena, width, height);
+    info->next = createNextBlock(&arena, size);
+  }
+  buffer->width = width;
+  buffer->height = height;
+  buffer->size = size;
+  buffer->back = 0;
+  atomic_init(&buffer->middle, 1);
+  buffer->front = 2;
+  return buffer;
+}
+
+void publishState(TripleBuffer *buffer, GameInfo_t info) {
+  GameInfo_t *slot = &buffer->slots[buffer->back];
+  memcpy(slot->field[0], info.field[0], (size_t)buffer->height * buffer->width);
+  memcpy(slot->next[0], info.next[0], (size_t)buffer->size * buffer->size);
+  info.field = slot->field;
+  info.next = slot->next;
+  *slot = info;
+  buffer->back = atomic_exchange_explicit(&buffer->middle,
+                                          buffer->back | FRESH,
+                                          memory_order_acq_rel) &
+                 ~FRESH;
+}
+
+int latestState(TripleBuffer *buffer, GameInfo_t *info) {
+  int fresh = 0;
+  if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & FRESH) {
+    buffer->front = atomic_exchange_explicit(&buffer->middle, buffer->front,
+                                             memory_order_acq_rel) &
+                    ~FRESH;
+    fresh = 1;
+  }
+  *info = buffer->slots[buffer->front];
+  return fresh;
+}
+
+void freeTripleBuffer(TripleBuffer *buffer) { free(buffer); }
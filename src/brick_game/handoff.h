@@ -0,0 +1,98 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+#include <stdatomic.h>
+
+#include "tetris.h"
+
+/**
+ * @def INPUT_RING_SIZE
+ * @brief Capacity of an InputRing, a power of two.
+ */
+#define INPUT_RING_SIZE 64
+
+/**
+ * @struct InputRing
+ * @brief Lock-free single-producer single-consumer queue of actions. head is
+ * only written by the consumer and tail only by the producer; they live on
+ * separate cache lines so the two threads do not share a line they write.
+ */
+typedef struct InputRing {
+  _Alignas(64) atomic_uint head;
+  _Alignas(64) atomic_uint tail;
+  uint8_t slots[INPUT_RING_SIZE];
+} InputRing;
+
+/**
+ * @struct TripleBuffer
+ * @brief Hands the latest game state from one writer thread to one reader
+ * thread without locks. Each of the three slots owns copies of the field and
+ * next cells. The writer fills its back slot and swaps it with the middle
+ * one; the reader swaps the middle slot into the front one when it holds a
+ * newer state. Neither side ever waits and the reader only sees whole states.
+ */
+typedef struct TripleBuffer {
+  GameInfo_t slots[3];
+  atomic_int middle;  ///< middle slot index, | 4 while it holds a new state
+  int back;
+  int front;
+  int width;
+  int height;
+  int size;
+} TripleBuffer;
+
+/**
+ * @brief Empties a ring.
+ * @param ring: Ring to reset, not in use by any thread.
+ */
+void initInputRing(InputRing *ring);
+
+/**
+ * @brief Appends an action. Producer side only.
+ * @param ring: Ring to push to.
+ * @param action: Action to queue.
+ * @return 1 on success, 0 when the ring is full.
+ */
+int pushInput(InputRing *ring, UserAction_t action);
+
+/**
+ * @brief Takes the oldest action. Consumer side only.
+ * @param ring: Ring to pop from.
+ * @param action: Receives the action.
+ * @return 1 on success, 0 when the ring is empty.
+ */
+int popInput(InputRing *ring, UserAction_t *action);
+
+/**
+ * @brief Allocates a triple buffer, slots included, in one block.
+ * @param width: Width of the field.
+ * @param height: Height of the field.
+ * @param size: Size of the next block.
+ * @return The buffer with no state published yet, or NULL when out of memory.
+ */
+TripleBuffer *createTripleBuffer(int width, int height, int size);
+
+/**
+ * @brief Copies a state into the back slot and publishes it. Writer side
+ * only.
+ * @param buffer: Buffer to publish to.
+ * @param info: State to copy; its field and next are read, not kept.
+ */
+void publishState(TripleBuffer *buffer, GameInfo_t info);
+
+/**
+ * @brief Takes the newest published state. Reader side only.
+ * @param buffer: Buffer to read.
+ * @param info: Receives the state; its field and next stay valid until the
+ * next call.
+ * @return 1 when the state is newer than the one returned before, 0 when
+ * nothing new was published.
+ */
+int latestState(TripleBuffer *buffer, GameInfo_t *info);
+
+/**
+ * @brief Frees a buffer made by createTripleBuffer().
+ * @param buffer: Buffer to free, may be NULL.
+ */
+void freeTripleBuffer(TripleBuffer *buffer);
+
+#endif
@@ -0,0 +1,105 @@
+#include <string.h>
+#include <unistd.h>
+
+#include "tetris.h"
+
+static const char board_magic[4] = {'B', 'G', 'H', 'S'};
+
+#define BOARD_VERSION 1
+#define ENTRY_BYTES 32  // name, then score, level and date little-endian
+
+static void putLe(unsigned char *out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint64_t getLe(const unsigned char *in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) value |= (uint64_t)in[i] << (8 * i);
+  return value;
+}
+
+static void packEntry(unsigned char *out, const ScoreEntry *entry) {
+  memcpy(out, entry->name, SCORE_NAME_SIZE);
+  putLe(out + SCORE_NAME_SIZE, (uint32_t)entry->score, 4);
+  putLe(out + SCORE_NAME_SIZE + 4, (uint32_t)entry->level, 4);
+  putLe(out + SCORE_NAME_SIZE + 8, (uint64_t)entry->date, 8);
+}
+
+static void unpackEntry(ScoreEntry *entry, const unsigned char *in) {
+  memcpy(entry->name, in, SCORE_NAME_SIZE);
+  entry->name[SCORE_NAME_SIZE - 1] = '\0';
+  entry->score = (int32_t)getLe(in + SCORE_NAME_SIZE, 4);
+  entry->level = (int32_t)getLe(in + SCORE_NAME_SIZE + 4, 4);
+  entry->date = (int64_t)getLe(in + SCORE_NAME_SIZE + 8, 8);
+}
+
+int submitScore(Leaderboard *board, const char *name, int score, int level,
+                time_t date) {
+  int rank = board->count;
+  while (rank > 0 && board->entries[rank - 1].score < score) rank--;
+  if (rank >= LEADERBOARD_SIZE) return -1;
+
+  int last = board->count < LEADERBOARD_SIZE ? board->count
+                                             : LEADERBOARD_SIZE - 1;
+  memmove(&board->entries[rank + 1], &board->entries[rank],
+          (size_t)(last - rank) * sizeof(ScoreEntry));
+  if (board->count < LEADERBOARD_SIZE) board->count++;
+
+  ScoreEntry *entry = &board->entries[rank];
+  memset(entry, 0, sizeof(*entry));
+  strncpy(entry->name, name ? name : "", SCORE_NAME_SIZE - 1);
+  entry->score = score;
+  entry->level = level;
+  entry->date = (int64_t)date;
+  return rank;
+}
+
+int saveHighScore(const Leaderboard *board, const char *path) {
+  char tmp[4096];
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+    return -1;
+  FILE *file = fopen(tmp, "wb");
+  if (file == NULL) return -1;
+
+  unsigned char header[8] = {0};
+  unsigned char entries[LEADERBOARD_SIZE * ENTRY_BYTES];
+  memcpy(header, board_magic, 4);
+  header[4] = BOARD_VERSION;
+  header[5] = (unsigned char)board->count;
+  for (int i = 0; i < LEADERBOARD_SIZE; i++)
+    packEntry(entries + i * ENTRY_BYTES, &board->entries[i]);
+  int ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+           fwrite(entries, 1, sizeof(entries), file) == sizeof(entries) &&
+           fflush(file) == 0 && fsync(fileno(file)) == 0;
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(tmp, path) != 0) {
+    remove(tmp);
+    return -1;
+  }
+  return 0;
+}
+
+int loadHighScore(Leaderboard *board, const char *path) {
+  unsigned char header[8];
+  unsigned char entries[LEADERBOARD_SIZE * ENTRY_BYTES];
+  memset(board, 0, sizeof(*board));
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) return 0;
+
+  if (fread(header, 1, sizeof(header), file) == sizeof(header) &&
+      memcmp(header, board_magic, 4) == 0 && header[4] == BOARD_VERSION &&
+      header[5] <= LEADERBOARD_SIZE &&
+      fread(entries, 1, sizeof(entries), file) == sizeof(entries)) {
+    board->count = header[5];
+    for (int i = 0; i < board->count; i++)
+      unpackEntry(&board->entries[i], entries + i * ENTRY_BYTES);
+  } else {
+    int legacy = 0;
+    memset(board, 0, sizeof(*board));
+    rewind(file);
+    if (fscanf(file, "%d", &legacy) == 1 && legacy > 0)
+      submitScore(board, "-", legacy, 0, 0);
+  }
+  fclose(file);
+  return board->count ? board->entries[0].score : 0;
+}
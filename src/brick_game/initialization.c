@@ -1,56 +1,126 @@
+#include <string.h>
+
 #include "figures.h"
 #include "tetris.h"
 
-Game *tetg;
-
-void initGame() {
-  tetg = createGame(10, 20, 5, 7);
+Game *initGame(uint64_t seed, bool bag) {
+  Game *tetg = createGame(10, 20, 5, 7);
+  if (tetg == NULL) return NULL;
+  seedGame(tetg, seed, bag);
 
-  Player *player = (Player *)malloc(sizeof(Player));
-  player->action = Start;
-  tetg->player = player;
+  tetg->player->action = Start;
   dropNewFigure(tetg);
+  return tetg;
+}
+
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+/**
+ * Bytes taken by a piece of the arena, padding included.
+ */
+static size_t arenaSpan(size_t size) {
+  return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+size_t gameArenaSize(int field_width, int field_height, int figures_size) {
+  size_t w = (size_t)field_width, h = (size_t)field_height;
+  size_t n = (size_t)figures_size;
+  size_t size = arenaSpan(sizeof(Game)) + arenaSpan(sizeof(Field)) +
+                arenaSpan(7 * sizeof(Block *)) + arenaSpan(sizeof(FiguresT)) +
+                arenaSpan(sizeof(Figure)) + arenaSpan(sizeof(Player)) +
+                arenaSpan(sizeof(EventQueue));
+  size += arenaSpan(h * sizeof(uint16_t)) + arenaSpan(h) + arenaSpan(w) +
+          arenaSpan(w * h);
+  size += 2 * (arenaSpan(h * sizeof(uint8_t *)) + arenaSpan(h * w));
+  size += 2 * (arenaSpan(n * sizeof(uint8_t *)) + arenaSpan(n * n));
+  return size;
+}
+
+void *arenaAlloc(Arena *arena, size_t size) {
+  size_t span = arenaSpan(size);
+  if (span > arena->size - arena->used) return NULL;
+  void *piece = arena->base + arena->used;
+  arena->used += span;
+  return piece;
+}
+
+/**
+ * Points every structure of the game at its place in the block behind tetg.
+ * Only pointers and dimensions are written, so this also rebases a copy.
+ */
+static void layoutGame(Game *tetg, int field_width, int field_height,
+                       int figures_size, int count) {
+  Arena arena = {(char *)tetg, 0, tetg->arena_size};
+  arenaAlloc(&arena, sizeof(Game));
+  tetg->field = createField(&arena, field_width, field_height);
+  tetg->tet_templates = createTemplates(&arena);
+  tetg->figurest =
+      createFiguresT(&arena, count, figures_size, tetg->tet_templates);
+  tetg->figure = (Figure *)arenaAlloc(&arena, sizeof(Figure));
+  tetg->player = (Player *)arenaAlloc(&arena, sizeof(Player));
+  tetg->events = (EventQueue *)arenaAlloc(&arena, sizeof(EventQueue));
+  for (int i = 0; i < 2; i++) {
+    tetg->print_field[i] =
+        createPrintField(&arena, field_width, field_height);
+    tetg->print_next[i] = createNextBlock(&arena, figures_size);
+  }
 }
 
 Game *createGame(int field_width, int field_height, int figures_size,
                  int count) {
-  Game *tetg = (Game *)malloc(sizeof(Game));
-  tetg->field = createField(field_width, field_height);
-  tetg->tet_templates = createTemplates();
-  tetg->figurest = createFiguresT(count, figures_size, tetg->tet_templates);
+  size_t size = gameArenaSize(field_width, field_height, figures_size);
+  Game *tetg = (Game *)calloc(1, size);
+  if (tetg == NULL) return NULL;
+  tetg->arena_size = size;
+  layoutGame(tetg, field_width, field_height, figures_size, count);
+  tetg->buffer = 0;
 
   tetg->score = 0;
-  tetg->high_score = loadHighScore();
+  tetg->high_score = 0;
   tetg->ticks = 30;
   tetg->ticks_left = 30;
   tetg->speed = 1;
   tetg->level = 1;
+  tetg->pieces = 0;
+  tetg->lines = 0;
+  tetg->cleared_rows = 0;
 
   tetg->pause = 1;
   tetg->state = INIT;
+  tetg->clock_ms = 0;
+  tetg->generation = 0;
+  tetg->profile = NULL;
 
-  tetg->next = rand() % tetg->figurest->count;
+  seedGame(tetg, 0, false);
 
   return tetg;
 }
 
-Field *createField(int width, int height) {
-  Field *tetf = (Field *)malloc(sizeof(Field));
+Game *cloneGame(const Game *tetg) {
+  Game *copy = (Game *)malloc(tetg->arena_size);
+  if (copy == NULL) return NULL;
+  memcpy(copy, tetg, tetg->arena_size);
+  layoutGame(copy, tetg->field->width, tetg->field->height,
+             tetg->figurest->size, tetg->figurest->count);
+  copy->profile = NULL;
+  return copy;
+}
+
+Field *createField(Arena *arena, int width, int height) {
+  Field *tetf = (Field *)arenaAlloc(arena, sizeof(Field));
   tetf->width = width;
   tetf->height = height;
-  tetf->blocks = (Block **)malloc(sizeof(Block *) * height);
-  for (int i = 0; i < height; i++) {
-    tetf->blocks[i] = (Block *)malloc(sizeof(Block) * width);
-    for (int j = 0; j < width; j++) {
-      tetf->blocks[i][j].b = 0;
-    }
-  }
+  tetf->full = (uint16_t)((1u << width) - 1);
+  tetf->rows = (uint16_t *)arenaAlloc(arena, height * sizeof(uint16_t));
+  tetf->fill = (uint8_t *)arenaAlloc(arena, height * sizeof(uint8_t));
+  tetf->heights = (uint8_t *)arenaAlloc(arena, width * sizeof(uint8_t));
+  tetf->cells = (uint8_t *)arenaAlloc(arena, (size_t)width * height);
 
   return tetf;
 }
 
-Block **createTemplates() {
-  Block **tet_templates = malloc(7 * sizeof(Block *));
+Block **createTemplates(Arena *arena) {
+  Block **tet_templates = (Block **)arenaAlloc(arena, 7 * sizeof(Block *));
   tet_templates[0] = &iFigure[0][0];
   tet_templates[1] = &oFigure[0][0];
   tet_templates[2] = &tFigure[0][0];
@@ -61,9 +131,9 @@ Block **createTemplates() {
   return tet_templates;
 }
 
-FiguresT *createFiguresT(int count, int figures_size,
+FiguresT *createFiguresT(Arena *arena, int count, int figures_size,
                          Block **figures_template) {
-  FiguresT *tetft = (FiguresT *)malloc(sizeof(FiguresT));
+  FiguresT *tetft = (FiguresT *)arenaAlloc(arena, sizeof(FiguresT));
   tetft->count = count;
   tetft->size = figures_size;
   tetft->blocks = figures_template;
@@ -72,73 +142,58 @@ FiguresT *createFiguresT(int count, int figures_size,
 }
 
 Figure *createFigure(Game *tetg) {
-  Figure *figure = (Figure *)malloc(sizeof(Figure));
-  figure->x = 0;
+  Figure *figure = tetg->figure;
+  figure->x = tetg->field->width / 2 - tetg->figurest->size / 2;
   figure->y = 0;
-  figure->size = tetg->figurest->size;
-  figure->blocks = (Block **)malloc(sizeof(Block *) * figure->size);
-  for (int i = 0; i < figure->size; i++) {
-    figure->blocks[i] = (Block *)malloc(sizeof(Block) * figure->size);
-    for (int j = 0; j < figure->size; j++) {
-      figure->blocks[i][j].b = 0;
-    }
-  }
+  figure->type = tetg->next;
+  figure->rot = 0;
   return figure;
 }
 
-int **createPrintField(int width, int height) {
-  int **print_field = (int **)malloc(height * sizeof(int *));
+uint8_t **createPrintField(Arena *arena, int width, int height) {
+  uint8_t **print_field =
+      (uint8_t **)arenaAlloc(arena, height * sizeof(uint8_t *));
+  uint8_t *cells = (uint8_t *)arenaAlloc(arena, (size_t)height * width);
   for (int i = 0; i < height; i++) {
-    print_field[i] = (int *)malloc(width * sizeof(int));
-  }
-
-  Field *field = tetg->field;
-  Figure *figure = tetg->figure;
-
-  for (int i = 0; i < field->height; i++) {
-    for (int j = 0; j < field->width; j++) {
-      int sym = 0;
-      if (field->blocks[i][j].b != 0)
-        sym = 1;
-      else {
-        int x = j - figure->x;
-        int y = i - figure->y;
-
-        if (x >= 0 && x < figure->size && y >= 0 && y < figure->size)
-          if (figure->blocks[y][x].b != 0) sym = 1;
-      }
-      print_field[i][j] = sym;
-    }
+    print_field[i] = cells + i * width;
   }
   return print_field;
 }
 
-int **createNextBlock(int size) {
-  int **next = (int **)malloc(size * sizeof(int *));
+uint8_t **createNextBlock(Arena *arena, int size) {
+  uint8_t **next = (uint8_t **)arenaAlloc(arena, size * sizeof(uint8_t *));
+  uint8_t *cells = (uint8_t *)arenaAlloc(arena, (size_t)size * size);
   for (int i = 0; i < size; i++) {
-    next[i] = (int *)malloc(size * sizeof(int));
-    for (int j = 0; j < tetg->figurest->size; j++) {
-      next[i][j] =
-          tetg->tet_templates[tetg->next][i * tetg->figurest->size + j].b;
-    }
+    next[i] = cells + i * size;
   }
   return next;
 }
 
-void saveHighScore(int high_score) {
-  FILE *file = fopen("high_score.dat", "w");
-  if (file != NULL) {
-    fprintf(file, "%d", high_score);
-    fclose(file);
+void fillPrintField(Game *tetg, uint8_t **print_field) {
+  Field *field = tetg->field;
+  Figure *figure = tetg->figure;
+  const Shape *shape = figureShape(figure);
+  int x = figure->x + shape->dx;
+  int width = field->width;  // byte stores may alias the field, keep a copy
+  uint8_t id = (uint8_t)(figure->type + 1);
+
+  for (int i = 0; i < field->height; i++)
+    memcpy(print_field[i], field->cells + i * width, width);
+  for (int y = 0; y < shape->h; y++) {
+    int i = figure->y + shape->dy + y;
+    if (i < 0 || i >= field->height) continue;
+    uint32_t bits = x >= 0 ? (uint32_t)shape->rows[y] << x
+                           : (uint32_t)shape->rows[y] >> -x;
+    for (bits &= field->full; bits; bits &= bits - 1)
+      print_field[i][__builtin_ctz(bits)] = id;
   }
 }
 
-int loadHighScore() {
-  int high_score = 0;
-  FILE *file = fopen("high_score.dat", "r");
-  if (file != NULL) {
-    fscanf(file, "%d", &high_score);
-    fclose(file);
-  }
-  return high_score;
+void fillNextBlock(Game *tetg, uint8_t **next) {
+  int size = tetg->figurest->size;
+  for (int i = 0; i < size; i++)
+    for (int j = 0; j < size; j++)
+      next[i][j] = tetg->tet_templates[tetg->next][i * size + j].b
+                       ? (uint8_t)(tetg->next + 1)
+                       : 0;
 }
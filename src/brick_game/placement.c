@@ -0,0 +1,182 @@
+#include "placement.h"
+
+#include <string.h>
+
+#include "figures.h"
+
+// A state is (y + PLACEMENT_MARGIN) << 7 | rot << 5 | (x + PLACEMENT_MARGIN),
+// so state >> 5 is its word in fits and visited and state & 31 its bit.
+#define STATE_BITS 5
+#define STATE_WORD(state) ((state) >> STATE_BITS)
+#define STATE_BIT(state) ((state) & 31)
+
+PlacementSearch *createPlacementSearch(int width, int height) {
+  if (width <= 0 || width > FIELD_MAX_WIDTH || height <= 0) return NULL;
+  size_t rows = (size_t)height + PLACEMENT_MARGIN;
+  size_t words = 4 * rows, states = words << STATE_BITS;
+  size_t boxes = 4 * (size_t)width * height;
+  if (states > UINT16_MAX + 1) return NULL;  // states are numbered in 16 bits
+  size_t total = sizeof(PlacementSearch) + 2 * words * sizeof(uint32_t) +
+                 4 * (size_t)height * sizeof(uint32_t) +
+                 states * (2 * sizeof(uint16_t) + 1) +
+                 boxes * sizeof(Placement) + 8 * _Alignof(max_align_t);
+  Arena arena = {calloc(1, total), 0, total};
+  if (arena.base == NULL) return NULL;
+
+  PlacementSearch *search =
+      (PlacementSearch *)arenaAlloc(&arena, sizeof(PlacementSearch));
+  search->width = width;
+  search->height = height;
+  search->cols = width + PLACEMENT_MARGIN;
+  search->rows = (int)rows;
+  search->fits = (uint32_t *)arenaAlloc(&arena, words * sizeof(uint32_t));
+  search->visited = (uint32_t *)arenaAlloc(&arena, words * sizeof(uint32_t));
+  search->landed =
+      (uint32_t *)arenaAlloc(&arena, 4 * (size_t)height * sizeof(uint32_t));
+  search->queue = (uint16_t *)arenaAlloc(&arena, states * sizeof(uint16_t));
+  search->parent = (uint16_t *)arenaAlloc(&arena, states * sizeof(uint16_t));
+  search->move = (uint8_t *)arenaAlloc(&arena, states);
+  search->placements =
+      (Placement *)arenaAlloc(&arena, boxes * sizeof(Placement));
+  search->count = 0;
+  return search;
+}
+
+/**
+ * First rotation of a figure type that covers the same blocks as rot.
+ */
+static int shapeClass(int type, int rot) {
+  const Shape *shape = &tetShapes[type][rot];
+  for (int r = 0; r < rot; r++) {
+    const Shape *other = &tetShapes[type][r];
+    if (other->w == shape->w && other->h == shape->h &&
+        !memcmp(other->rows, shape->rows, shape->h * sizeof(shape->rows[0])))
+      return r;
+  }
+  return rot;
+}
+
+/**
+ * Fills search->fits for every position of the figure type, built from the
+ * field's row bitboards.
+ */
+static void findFits(PlacementSearch *search, const Field *field, int type) {
+  memset(search->fits, 0, 4 * search->rows * sizeof(uint32_t));
+  for (int rot = 0; rot < 4; rot++) {
+    const Shape *shape = &tetShapes[type][rot];
+    for (int by = 0; by + shape->h <= field->height; by++) {
+      int i = by - shape->dy + PLACEMENT_MARGIN;
+      uint32_t *fits = &search->fits[i * 4 + rot];
+      for (int bx = 0; bx + shape->w <= field->width; bx++) {
+        int free = 1;
+        for (int r = 0; r < shape->h && free; r++)
+          free = !(field->rows[by + r] & (uint16_t)(shape->rows[r] << bx));
+        if (free) *fits |= 1u << (bx - shape->dx + PLACEMENT_MARGIN);
+      }
+    }
+  }
+}
+
+/**
+ * State of the figure at x, y with rotation rot, or -1 when it does not fit
+ * there.
+ */
+static int fitsAt(const PlacementSearch *search, int x, int y, int rot) {
+  int i = y + PLACEMENT_MARGIN, bit = x + PLACEMENT_MARGIN;
+  if (i < 0 || i >= search->rows || bit < 0 || bit >= search->cols) return -1;
+  int word = i * 4 + rot;
+  if (!((search->fits[word] >> bit) & 1)) return -1;
+  return word << STATE_BITS | bit;
+}
+
+/**
+ * Marks a state as reached from parent by move and queues it, unless it was
+ * reached before.
+ */
+static void visit(PlacementSearch *search, int *tail, int state, int parent,
+                  UserAction_t move) {
+  uint32_t *visited = &search->visited[STATE_WORD(state)];
+  if ((*visited >> STATE_BIT(state)) & 1) return;
+  *visited |= 1u << STATE_BIT(state);
+  search->parent[state] = (uint16_t)(parent < 0 ? state : parent);
+  search->move[state] = (uint8_t)move;
+  search->queue[(*tail)++] = (uint16_t)state;
+}
+
+/**
+ * Lists the resting state unless a placement with the same blocks is
+ * already listed. The state was reached by a shortest path, so the first
+ * listing of some blocks has the fewest inputs.
+ */
+static void land(PlacementSearch *search, int type, int x, int y, int rot,
+                 int state) {
+  const Shape *shape = &tetShapes[type][rot];
+  int bx = x + shape->dx, by = y + shape->dy;
+  uint32_t *landed =
+      &search->landed[shapeClass(type, rot) * search->height + by];
+  if ((*landed >> bx) & 1) return;
+  *landed |= 1u << bx;
+
+  int length = 1, s = state;  // HardDrop replaces the final run of Downs
+  while (search->move[s] == Down) s = search->parent[s];
+  for (; search->parent[s] != s; s = search->parent[s]) length++;
+  search->placements[search->count++] =
+      (Placement){(int8_t)x, (int8_t)y, (uint8_t)rot, (uint16_t)length,
+                  (uint16_t)state};
+}
+
+int findPlacements(PlacementSearch *search, const Game *tetg) {
+  static const UserAction_t steps[] = {Up, Left, Right, Down};
+  const Figure *figure = tetg->figure;
+  int head = 0, tail = 0;
+
+  findFits(search, tetg->field, figure->type);
+  memset(search->visited, 0, 4 * search->rows * sizeof(uint32_t));
+  memset(search->landed, 0, 4 * search->height * sizeof(uint32_t));
+  search->count = 0;
+  int start = fitsAt(search, figure->x, figure->y, figure->rot);
+  if (start < 0) return 0;
+  visit(search, &tail, start, -1, Action);
+
+  while (head < tail) {
+    int state = search->queue[head++];
+    int x = STATE_BIT(state) - PLACEMENT_MARGIN;
+    int rot = STATE_WORD(state) & 3;
+    int y = (STATE_WORD(state) >> 2) - PLACEMENT_MARGIN;
+    for (int k = 0; k < 4; k++) {
+      int next = fitsAt(search, x + (steps[k] == Right) - (steps[k] == Left),
+                        y + (steps[k] == Down),
+                        steps[k] == Up ? (rot + 1) & 3 : rot);
+      if (next >= 0)
+        visit(search, &tail, next, state, steps[k]);
+      else if (steps[k] == Down)
+        land(search, figure->type, x, y, rot, state);
+    }
+  }
+  return search->count;
+}
+
+int placementInputs(const PlacementSearch *search, const Placement *placement,
+                    UserAction_t *out, int max) {
+  int length = placement->length, s = placement->state;
+  while (search->move[s] == Down) s = search->parent[s];
+  if (length - 1 < max) out[length - 1] = HardDrop;
+  for (int k = length - 2; k >= 0; k--, s = search->parent[s])
+    if (k < max) out[k] = (UserAction_t)search->move[s];
+  return length;
+}
+
+void applyPlacement(Game *tetg, const PlacementSearch *search,
+                    const Placement *placement) {
+  int s = placement->state;
+  while (search->move[s] == Down) s = search->parent[s];
+  Figure *figure = tetg->figure;
+  figure->x = STATE_BIT(s) - PLACEMENT_MARGIN;
+  figure->y = (STATE_WORD(s) >> 2) - PLACEMENT_MARGIN;
+  figure->rot = STATE_WORD(s) & 3;
+  tetg->generation++;
+  emitEvent(tetg, EVENT_MOVE, 0);
+  hardDrop(tetg);
+}
+
+void freePlacementSearch(PlacementSearch *search) { free(search); }
@@ -0,0 +1,105 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+#include "tetris.h"
+
+/**
+ * @def PLACEMENT_MARGIN
+ * @brief How far a figure's 5x5 frame can stick out to the left of or above
+ * the field while its blocks are inside.
+ */
+#define PLACEMENT_MARGIN 4
+
+/**
+ * @struct Placement
+ * @brief One place where the falling figure can come to rest. x, y and rot
+ * are the figure's position as in Figure. length is the number of inputs
+ * that take the figure there from where it was, see placementInputs().
+ */
+typedef struct Placement {
+  int8_t x;
+  int8_t y;
+  uint8_t rot;
+  uint16_t length;
+  uint16_t state;  ///< end of the path in the search's tables
+} Placement;
+
+/**
+ * @struct PlacementSearch
+ * @brief Working memory of findPlacements() for fields of one size. A state
+ * is a figure position (x, y, rot). fits and visited hold one bit per state:
+ * bit x of word y * 4 + rot, both offset by PLACEMENT_MARGIN. parent and
+ * move keep the step each state was first reached by. Every search reuses
+ * the same block, so none allocates.
+ */
+typedef struct PlacementSearch {
+  int width;
+  int height;
+  int cols;               ///< x positions: width + PLACEMENT_MARGIN
+  int rows;               ///< y positions: height + PLACEMENT_MARGIN
+  uint32_t *fits;         ///< states where the figure lies on free cells
+  uint32_t *visited;      ///< states already reached
+  uint32_t *landed;       ///< bit x of word rot * height + y per listed box
+  uint16_t *queue;        ///< states in the order they were reached
+  uint16_t *parent;       ///< state each state was reached from
+  uint8_t *move;          ///< UserAction_t that led to each state
+  Placement *placements;  ///< result of the last search
+  int count;              ///< number of placements
+} PlacementSearch;
+
+/**
+ * @brief Allocates the working memory for searches on fields of the given
+ * size.
+ * @param width: Field width, at most FIELD_MAX_WIDTH.
+ * @param height: Field height.
+ * @return The search, or NULL when the field is too large or out of memory.
+ */
+PlacementSearch *createPlacementSearch(int width, int height);
+
+/**
+ * @brief Lists every resting place the falling figure can reach with Left,
+ * Right, Up and Down from where it is now, slides and tucks under overhangs
+ * included. The search is breadth first, so each placement comes with one of
+ * its shortest input sequences. Rotations that cover the same blocks are
+ * listed once. Gravity is not taken into account.
+ * @param search: Working memory made for the game's field size.
+ * @param tetg: Game whose figure is placed; it is not changed.
+ * @return Number of placements, also in search->count. They are in
+ * search->placements until the next search.
+ */
+int findPlacements(PlacementSearch *search, const Game *tetg);
+
+/**
+ * @brief Writes the inputs that bring the figure to a placement: moves and
+ * rotations, then HardDrop to lock it. The path assumes no gravity step
+ * happens on the way. userInput() holds at most INPUT_QUEUE_SIZE presses
+ * and drops the rest, so only placements whose length fits the queue can
+ * be played by queueing their inputs and calling applyAction() once; use
+ * applyPlacement() for any placement.
+ * @param search: Search the placement came from.
+ * @param placement: One of search->placements.
+ * @param out: Where to write the inputs.
+ * @param max: Room in out; longer sequences are cut short.
+ * @return placement->length, the full number of inputs.
+ */
+int placementInputs(const PlacementSearch *search, const Placement *placement,
+                    UserAction_t *out, int max);
+
+/**
+ * @brief Takes the falling figure to a placement and plants it there, as its
+ * inputs would without gravity: the figure moves to where the final
+ * HardDrop starts and hardDrop() locks it, scoring and spawning the next
+ * figure.
+ * @param tetg: Game the search was run on, its figure not moved since.
+ * @param search: Search the placement came from.
+ * @param placement: One of search->placements.
+ */
+void applyPlacement(Game *tetg, const PlacementSearch *search,
+                    const Placement *placement);
+
+/**
+ * @brief Frees a search.
+ * @param search: Search to free, or NULL.
+ */
+void freePlacementSearch(PlacementSearch *search);
+
+#endif
@@ -0,0 +1,102 @@
+#include "profile.h"
+
+static const char *phase_names[PHASE_COUNT] = {
+    "input", "simulate", "step", "export", "render", "sleep", "frame", "latency"};
+
+uint64_t monotonicNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Bucket of a sample: values below 4 map to themselves, larger ones to four
+ * sub-buckets per power of two.
+ */
+static int bucketOf(uint64_t ns) {
+  if (ns < 4) return (int)ns;
+  int msb = 63 - __builtin_clzll(ns);
+  int bucket = 4 * (msb - 1) + (int)((ns >> (msb - 2)) & 3);
+  return bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1;
+}
+
+/**
+ * Largest value that falls into a bucket.
+ */
+static uint64_t bucketLimit(int bucket) {
+  if (bucket < 4) return (uint64_t)bucket;
+  int msb = bucket / 4 + 1;
+  return ((uint64_t)(4 + bucket % 4 + 1) << (msb - 2)) - 1;
+}
+
+void recordLatency(Histogram *hist, uint64_t ns) {
+  hist->count++;
+  hist->total_ns += ns;
+  if (ns > hist->max_ns) hist->max_ns = ns;
+  hist->buckets[bucketOf(ns)]++;
+}
+
+uint64_t histogramPercentile(const Histogram *hist, double p) {
+  if (hist->count == 0) return 0;
+  double target = p * (double)hist->count;
+  uint64_t rank = (uint64_t)target;
+  if ((double)rank < target || rank < 1) rank++;
+  if (rank > hist->count) rank = hist->count;
+  uint64_t seen = 0;
+  for (int i = 0; i < PROFILE_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= rank) {
+      uint64_t limit = bucketLimit(i);
+      return limit < hist->max_ns ? limit : hist->max_ns;
+    }
+  }
+  return hist->max_ns;
+}
+
+uint64_t profileStart(Profile *profile) {
+  return profile != NULL ? monotonicNs() : 0;
+}
+
+void profileLap(Profile *profile, Phase phase, uint64_t *mark) {
+  if (profile == NULL) return;
+  uint64_t now = monotonicNs();
+  recordLatency(&profile->phases[phase], now - *mark);
+  *mark = now;
+}
+
+void writeProfileText(const Profile *profile, FILE *file) {
+  fprintf(file, "%-9s %9s %10s %10s %10s %10s\n", "phase", "count", "mean us",
+          "p50 us", "p99 us", "max us");
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    const Histogram *hist = &profile->phases[i];
+    double mean = hist->count ? (double)hist->total_ns / hist->count : 0;
+    fprintf(file, "%-9s %9llu %10.1f %10.1f %10.1f %10.1f\n", phase_names[i],
+            (unsigned long long)hist->count, mean / 1000,
+            histogramPercentile(hist, 0.5) / 1000.0,
+            histogramPercentile(hist, 0.99) / 1000.0, hist->max_ns / 1000.0);
+  }
+}
+
+void writeProfileJson(const Profile *profile, FILE *file) {
+  fprintf(file, "{");
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    const Histogram *hist = &profile->phases[i];
+    fprintf(file,
+            "%s\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"p50_ns\":%llu,"
+            "\"p99_ns\":%llu,\"max_ns\":%llu,\"buckets\":[",
+            i ? "," : "", phase_names[i], (unsigned long long)hist->count,
+            (unsigned long long)hist->total_ns,
+            (unsigned long long)histogramPercentile(hist, 0.5),
+            (unsigned long long)histogramPercentile(hist, 0.99),
+            (unsigned long long)hist->max_ns);
+    int first = 1;
+    for (int b = 0; b < PROFILE_BUCKETS; b++) {
+      if (hist->buckets[b] == 0) continue;
+      fprintf(file, "%s[%llu,%u]", first ? "" : ",",
+              (unsigned long long)bucketLimit(b), hist->buckets[b]);
+      first = 0;
+    }
+    fprintf(file, "]}");
+  }
+  fprintf(file, "}\n");
+}
@@ -0,0 +1,105 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+#include "tetris.h"
+
+/**
+ * @def PROFILE_BUCKETS
+ * @brief Number of histogram buckets. Buckets are log-linear: four per power
+ * of two, so a bucket is at most 25% wide, up to about 18 minutes.
+ */
+#define PROFILE_BUCKETS 160
+
+/**
+ * @enum Phase
+ * @brief Parts of a frame that are timed separately. PHASE_STEP (one gravity
+ * step, calcOne) runs inside PHASE_SIMULATE; PHASE_FRAME covers the whole
+ * loop iteration. PHASE_LATENCY is not a phase of the loop: it is the time
+ * from userInput() queueing a key press to the engine applying it.
+ */
+typedef enum {
+  PHASE_INPUT,
+  PHASE_SIMULATE,
+  PHASE_STEP,
+  PHASE_EXPORT,
+  PHASE_RENDER,
+  PHASE_SLEEP,
+  PHASE_FRAME,
+  PHASE_LATENCY,
+  PHASE_COUNT
+} Phase;
+
+/**
+ * @struct Histogram
+ * @brief Latency histogram of one phase, in nanoseconds.
+ */
+typedef struct Histogram {
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint32_t buckets[PROFILE_BUCKETS];
+} Histogram;
+
+/**
+ * @struct Profile
+ * @brief Histograms of every phase. Attach one to Game::profile to time the
+ * engine; the frontend records the phases it runs itself.
+ */
+typedef struct Profile {
+  Histogram phases[PHASE_COUNT];
+} Profile;
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Nanoseconds since an arbitrary start.
+ */
+uint64_t monotonicNs();
+
+/**
+ * @brief Adds one sample to a histogram.
+ * @param hist: Histogram to update.
+ * @param ns: Sample in nanoseconds.
+ */
+void recordLatency(Histogram *hist, uint64_t ns);
+
+/**
+ * @brief Estimates a percentile from the histogram buckets.
+ * @param hist: Histogram to read.
+ * @param p: Percentile between 0 and 1.
+ * @return Upper bound of the bucket holding the percentile, never above the
+ * largest sample. 0 for an empty histogram.
+ */
+uint64_t histogramPercentile(const Histogram *hist, double p);
+
+/**
+ * @brief Starts timing a phase.
+ * @param profile: Profile in use, may be NULL.
+ * @return Current time, or 0 without a profile.
+ */
+uint64_t profileStart(Profile *profile);
+
+/**
+ * @brief Records the time since mark for a phase and moves mark to now, so
+ * consecutive phases can be timed with one clock read each. Does nothing
+ * without a profile.
+ * @param profile: Profile in use, may be NULL.
+ * @param phase: Phase that just ended.
+ * @param mark: Start of the phase; receives its end.
+ */
+void profileLap(Profile *profile, Phase phase, uint64_t *mark);
+
+/**
+ * @brief Writes count, mean, p50, p99 and max of every phase as a table.
+ * @param profile: Profile to report.
+ * @param file: Destination stream.
+ */
+void writeProfileText(const Profile *profile, FILE *file);
+
+/**
+ * @brief Writes the same report as JSON, including the raw non-empty
+ * buckets as [upper bound ns, count] pairs.
+ * @param profile: Profile to report.
+ * @param file: Destination stream.
+ */
+void writeProfileJson(const Profile *profile, FILE *file);
+
+#endif
@@ -0,0 +1,53 @@
+#include "tetris.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+#define PCG_INCREMENT 1442695040888963407ULL
+
+void seedRng(Rng *rng, uint64_t seed) {
+  rng->state = 0;
+  nextRandom(rng);
+  rng->state += seed;
+  nextRandom(rng);
+}
+
+uint32_t nextRandom(Rng *rng) {
+  uint64_t old = rng->state;
+  rng->state = old * PCG_MULTIPLIER + PCG_INCREMENT;
+  uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+  uint32_t rot = (uint32_t)(old >> 59);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+uint32_t randomBelow(Rng *rng, uint32_t bound) {
+  return (uint32_t)(((uint64_t)nextRandom(rng) * bound) >> 32);
+}
+
+void seedGame(Game *tetg, uint64_t seed, bool bag) {
+  seedRng(&tetg->rng, seed);
+  tetg->bag = bag;
+  tetg->queued = 0;
+  tetg->next = nextFigureType(tetg);
+}
+
+/**
+ * Deals a new bag: every template once, shuffled with Fisher-Yates. The
+ * queue is consumed from the end.
+ */
+static void fillBag(Game *tetg) {
+  int count = tetg->figurest->count;
+  for (int i = 0; i < count; i++) tetg->queue[i] = i;
+  for (int i = count - 1; i > 0; i--) {
+    int j = (int)randomBelow(&tetg->rng, (uint32_t)i + 1);
+    int t = tetg->queue[i];
+    tetg->queue[i] = tetg->queue[j];
+    tetg->queue[j] = t;
+  }
+  tetg->queued = count;
+}
+
+int nextFigureType(Game *tetg) {
+  if (!tetg->bag)
+    return (int)randomBelow(&tetg->rng, (uint32_t)tetg->figurest->count);
+  if (tetg->queued == 0) fillBag(tetg);
+  return tetg->queue[--tetg->queued];
+}
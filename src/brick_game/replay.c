@@ -0,0 +1,121 @@
+#include "replay.h"
+
+#include <string.h>
+
+static const char replay_magic[4] = {'B', 'G', 'R', 'P'};
+
+#define REPLAY_VERSION 1
+
+static void writeVarint(FILE *file, uint64_t value) {
+  while (value >= 0x80) {
+    fputc((int)(value & 0x7F) | 0x80, file);
+    value >>= 7;
+  }
+  fputc((int)value, file);
+}
+
+static int readVarint(FILE *file, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = fgetc(file);
+    if (c == EOF) return 0;
+    *value |= (uint64_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) return 1;
+  }
+  return 0;
+}
+
+Recorder *openRecorder(const char *path, uint64_t seed, bool bag) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) return NULL;
+  Recorder *rec = (Recorder *)malloc(sizeof(Recorder));
+  rec->file = file;
+  rec->frame = 0;
+
+  unsigned char header[14];
+  for (int i = 0; i < 4; i++) header[i] = (unsigned char)replay_magic[i];
+  header[4] = REPLAY_VERSION;
+  header[5] = bag ? 1 : 0;
+  for (int i = 0; i < 8; i++) header[6 + i] = (unsigned char)(seed >> (8 * i));
+  fwrite(header, 1, sizeof(header), file);
+  return rec;
+}
+
+void recordAction(Recorder *rec, long frame, UserAction_t action) {
+  writeVarint(rec->file, (uint64_t)(frame - rec->frame) << 4 | action);
+  rec->frame = frame;
+}
+
+void closeRecorder(Recorder *rec, long frame) {
+  if (rec) {
+    writeVarint(rec->file, (uint64_t)(frame - rec->frame) << 4 | REPLAY_END);
+    fclose(rec->file);
+    free(rec);
+  }
+}
+
+Replay *openReplay(const char *path) {
+  FILE *file = fopen(path, "rb");
+  unsigned char header[14];
+  if (file == NULL) return NULL;
+  if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+      memcmp(header, replay_magic, 4) != 0 || header[4] != REPLAY_VERSION) {
+    fclose(file);
+    return NULL;
+  }
+  Replay *rp = (Replay *)malloc(sizeof(Replay));
+  rp->file = file;
+  rp->frame = 0;
+  rp->bag = header[5] & 1;
+  rp->seed = 0;
+  for (int i = 0; i < 8; i++) rp->seed |= (uint64_t)header[6 + i] << (8 * i);
+  return rp;
+}
+
+int nextReplayAction(Replay *rp, long *frame, int *action) {
+  uint64_t record;
+  if (!readVarint(rp->file, &record)) return 0;
+  rp->frame += (long)(record >> 4);
+  *frame = rp->frame;
+  *action = (int)(record & 0xF);
+  return 1;
+}
+
+void closeReplay(Replay *rp) {
+  if (rp) {
+    fclose(rp->file);
+    free(rp);
+  }
+}
+
+int replayGame(const char *path, GameResult *result) {
+  Replay *rp = openReplay(path);
+  if (rp == NULL) return -1;
+
+  Game *tetg = initGame(rp->seed, rp->bag);
+  if (tetg == NULL) {
+    closeReplay(rp);
+    return -1;
+  }
+  long frame = 0, at = 0;
+  int action = REPLAY_END;
+  int more = nextReplayAction(rp, &at, &action);
+
+  while (tetg->state != GAMEOVER && more &&
+         !(at == frame && action == REPLAY_END)) {
+    while (more && at == frame && action != REPLAY_END) {
+      userInput(tetg, (UserAction_t)action, 0);
+      more = nextReplayAction(rp, &at, &action);
+    }
+    calculate(tetg);
+    frame++;
+  }
+  result->score = tetg->score;
+  result->level = tetg->level;
+  result->lines = tetg->lines;
+  result->pieces = tetg->pieces;
+  result->frames = frame;
+  freeGame(tetg);
+  closeReplay(rp);
+  return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+#include "simulation.h"
+
+/**
+ * @def REPLAY_END
+ * @brief Action code of the record that closes a replay file.
+ */
+#define REPLAY_END 15
+
+/**
+ * @struct Recorder
+ * @brief Streams the inputs of a game to a replay file.
+ *
+ * A replay file starts with the magic "BGRP", a version byte, a flags byte
+ * (bit 0: 7-bag generator) and the 64-bit little-endian seed. Each following
+ * record is one LEB128 varint holding (frames since the previous record << 4)
+ * | action. The last record carries REPLAY_END at the frame the game stopped.
+ */
+typedef struct Recorder {
+  FILE *file;
+  long frame;
+} Recorder;
+
+/**
+ * @struct Replay
+ * @brief Reads a replay file record by record.
+ */
+typedef struct Replay {
+  FILE *file;
+  long frame;
+  uint64_t seed;
+  bool bag;
+} Replay;
+
+/**
+ * @brief Creates a replay file and writes its header.
+ * @param path: File to create.
+ * @param seed: Seed the game was created with.
+ * @param bag: Whether the game uses the 7-bag generator.
+ * @return The recorder, or NULL if the file cannot be created.
+ */
+Recorder *openRecorder(const char *path, uint64_t seed, bool bag);
+
+/**
+ * @brief Appends one input to the replay.
+ * @param rec: Recorder to write to.
+ * @param frame: Frame (call of calculate()) the action was fed in; frames must
+ * not decrease.
+ * @param action: The action.
+ */
+void recordAction(Recorder *rec, long frame, UserAction_t action);
+
+/**
+ * @brief Writes the closing record and releases the recorder.
+ * @param rec: Recorder to close.
+ * @param frame: Number of frames the game ran.
+ */
+void closeRecorder(Recorder *rec, long frame);
+
+/**
+ * @brief Opens a replay file and reads its header.
+ * @param path: File to read.
+ * @return The reader, or NULL if the file is missing or not a replay.
+ */
+Replay *openReplay(const char *path);
+
+/**
+ * @brief Reads the next record of a replay.
+ * @param rp: Replay to read from.
+ * @param frame: Receives the frame of the record.
+ * @param action: Receives the action, REPLAY_END for the closing record.
+ * @return 1 on success, 0 at the end of the file.
+ */
+int nextReplayAction(Replay *rp, long *frame, int *action);
+
+/**
+ * @brief Releases a replay reader.
+ * @param rp: Replay to close.
+ */
+void closeReplay(Replay *rp);
+
+/**
+ * @brief Plays a replay file back through the engine headlessly, as fast as
+ * possible, feeding each recorded action at its frame.
+ * @param path: Replay file.
+ * @param result: Outcome of the replayed game.
+ * @return 0 on success, -1 if the file cannot be read or the game cannot be
+ * allocated.
+ */
+int replayGame(const char *path, GameResult *result);
+
+#endif
@@ -0,0 +1,48 @@
+#include "tetris.h"
+
+static const int gravity_ms[] = {800, 720, 630, 550, 470,
+                                 380, 300, 220, 150, 100};
+
+int gravityInterval(int level) {
+  int count = (int)(sizeof(gravity_ms) / sizeof(gravity_ms[0]));
+  if (level < 1) level = 1;
+  if (level > count) level = count;
+  return gravity_ms[level - 1];
+}
+
+void startClock(Game *tetg, long now_ms) { tetg->clock_ms = now_ms; }
+
+void resumeClock(Game *tetg, int was_paused, long now_ms) {
+  if (was_paused && !tetg->pause) startClock(tetg, now_ms);
+}
+
+int advanceClock(Game *tetg, long now_ms) {
+  int steps = 0;
+  if (tetg->pause || tetg->state == GAMEOVER) {
+    tetg->clock_ms = now_ms;
+    return 0;
+  }
+  while (now_ms - tetg->clock_ms >= gravityInterval(tetg->level) &&
+         tetg->state != GAMEOVER) {
+    if (steps == MAX_CATCHUP_STEPS) {
+      tetg->clock_ms = now_ms;  // too late to catch up, drop the backlog
+      break;
+    }
+    tetg->clock_ms += gravityInterval(tetg->level);
+    calcOne(tetg);
+    steps++;
+  }
+  return steps;
+}
+
+long nextStepDelay(const Game *tetg, long now_ms) {
+  if (tetg->pause || tetg->state == GAMEOVER) return -1;
+  long delay = tetg->clock_ms + gravityInterval(tetg->level) - now_ms;
+  return delay > 0 ? delay : 0;
+}
+
+long monotonicMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
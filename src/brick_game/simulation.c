@@ -0,0 +1,143 @@
+#include "simulation.h"
+
+#include <string.h>
+
+UserAction_t scriptAction(char c) {
+  switch (c) {
+    case 'L':
+      return Left;
+    case 'R':
+      return Right;
+    case 'U':
+      return Up;
+    case 'D':
+      return Down;
+    case 'S':
+      return Start;
+    case 'P':
+      return Pause;
+    case 'Q':
+      return Terminate;
+    case 'H':
+      return HardDrop;
+    default:
+      return Action;
+  }
+}
+
+/**
+ * Picks the action for one frame of a random player: mostly idle, otherwise
+ * an even mix of moves, rotations and soft drops.
+ */
+static UserAction_t randomAction(Rng *rng) {
+  static const UserAction_t moves[] = {Left, Right, Up, Down};
+  uint32_t r = randomBelow(rng, 8);
+  return r < 4 ? moves[r] : Action;
+}
+
+int simulateFrames(long frames, const char *script, uint64_t seed,
+                   SimStats *stats) {
+  size_t script_len = script ? strlen(script) : 0;
+  double start = monotonicSeconds();
+  Rng input;
+
+  *stats = (SimStats){0};
+  seedRng(&input, ~seed);
+  Game *tetg = initGame(seed, false);
+  if (tetg == NULL) return -1;
+  userInput(tetg, Start, 0);
+  updateCurrentState(tetg);
+
+  for (long f = 1; f < frames; f++) {
+    UserAction_t action = script_len ? scriptAction(script[f % script_len])
+                                     : randomAction(&input);
+    userInput(tetg, action, 0);
+    updateCurrentState(tetg);
+
+    if (tetg->state == GAMEOVER) {
+      stats->pieces += tetg->pieces;
+      stats->lines += tetg->lines;
+      stats->games++;
+      freeGame(tetg);
+      tetg = initGame(seed + stats->games, false);
+      if (tetg == NULL) return -1;
+      userInput(tetg, Start, 0);
+      updateCurrentState(tetg);
+    }
+  }
+  stats->frames = frames;
+  stats->pieces += tetg->pieces;
+  stats->lines += tetg->lines;
+  stats->games++;
+  freeGame(tetg);
+  stats->seconds = monotonicSeconds() - start;
+  return 0;
+}
+
+int simulateGame(const char *script, uint64_t seed, bool bag, long max_frames,
+                 GameResult *result) {
+  size_t script_len = script ? strlen(script) : 0;
+  Game *tetg = initGame(seed, bag);
+  long f = 0;
+  Rng input;
+
+  if (tetg == NULL) return -1;
+  seedRng(&input, ~seed);
+  userInput(tetg, Start, 0);
+  calculate(tetg);
+  while (tetg->state != GAMEOVER && ++f < max_frames) {
+    UserAction_t action = script_len ? scriptAction(script[f % script_len])
+                                     : randomAction(&input);
+    userInput(tetg, action, 0);
+    calculate(tetg);
+  }
+  result->score = tetg->score;
+  result->level = tetg->level;
+  result->lines = tetg->lines;
+  result->pieces = tetg->pieces;
+  result->frames = f;
+  freeGame(tetg);
+  return 0;
+}
+
+/**
+ * Adds one value to a statistic; the first value of a batch sets the range.
+ */
+static void addStat(StatRange *range, long value, int first) {
+  range->sum += value;
+  if (first || value < range->min) range->min = value;
+  if (first || value > range->max) range->max = value;
+}
+
+static void mergeStat(StatRange *dst, const StatRange *src, int first) {
+  dst->sum += src->sum;
+  if (first || src->min < dst->min) dst->min = src->min;
+  if (first || src->max > dst->max) dst->max = src->max;
+}
+
+void addGameResult(BatchStats *stats, const GameResult *result) {
+  int first = stats->games == 0;
+  addStat(&stats->score, result->score, first);
+  addStat(&stats->level, result->level, first);
+  addStat(&stats->lines, result->lines, first);
+  addStat(&stats->pieces, result->pieces, first);
+  addStat(&stats->frames, result->frames, first);
+  stats->games++;
+}
+
+void mergeBatchStats(BatchStats *dst, const BatchStats *src) {
+  int first = dst->games == 0;
+  if (src->games == 0) return;
+  mergeStat(&dst->score, &src->score, first);
+  mergeStat(&dst->level, &src->level, first);
+  mergeStat(&dst->lines, &src->lines, first);
+  mergeStat(&dst->pieces, &src->pieces, first);
+  mergeStat(&dst->frames, &src->frames, first);
+  dst->games += src->games;
+}
+
+double monotonicSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,110 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+#include "tetris.h"
+
+/**
+ * @struct SimStats
+ * @brief Totals collected by a headless simulation run.
+ */
+typedef struct SimStats {
+  long frames;
+  long pieces;
+  long lines;
+  long games;
+  double seconds;
+} SimStats;
+
+/**
+ * @struct GameResult
+ * @brief Outcome of one complete headless game.
+ */
+typedef struct GameResult {
+  long score;
+  long level;
+  long lines;
+  long pieces;
+  long frames;
+} GameResult;
+
+/**
+ * @struct StatRange
+ * @brief Sum, minimum and maximum of one statistic over many games.
+ */
+typedef struct StatRange {
+  long sum;
+  long min;
+  long max;
+} StatRange;
+
+/**
+ * @struct BatchStats
+ * @brief Aggregated results of a batch of games.
+ */
+typedef struct BatchStats {
+  long games;
+  StatRange score;
+  StatRange level;
+  StatRange lines;
+  StatRange pieces;
+  StatRange frames;
+} BatchStats;
+
+/**
+ * @brief Maps a script character to a user action: 'L' left, 'R' right, 'U'
+ * rotate, 'D' down, 'H' hard drop, 'S' start, 'P' pause, 'Q' terminate. Any
+ * other character is an idle frame.
+ * @param c: Script character.
+ * @return The matching action.
+ */
+UserAction_t scriptAction(char c);
+
+/**
+ * @brief Plays games without a terminal and without sleeping, feeding one
+ * action per frame through userInput() and updateCurrentState(). A game that
+ * ends is replaced by a new one until the frame budget is spent.
+ * @param frames: Number of frames to simulate.
+ * @param script: Actions to cycle through, see scriptAction(), or NULL for
+ * random input.
+ * @param seed: Seed for piece generation and random input. The n-th game
+ * of the run is seeded with seed + n.
+ * @param stats: Totals of the run.
+ * @return 0 on success, -1 if a game cannot be allocated.
+ */
+int simulateFrames(long frames, const char *script, uint64_t seed,
+                    SimStats *stats);
+
+/**
+ * @brief Plays one complete game headlessly, stepping calculate() directly so
+ * no frame is exported. The game ends on game over or after max_frames.
+ * @param script: Actions to cycle through, see scriptAction(), or NULL for
+ * random input.
+ * @param seed: Seed for piece generation and random input.
+ * @param bag: true to deal pieces with the 7-bag generator.
+ * @param max_frames: Upper bound on the game length.
+ * @param result: Outcome of the game.
+ * @return 0 on success, -1 if the game cannot be allocated.
+ */
+int simulateGame(const char *script, uint64_t seed, bool bag, long max_frames,
+                 GameResult *result);
+
+/**
+ * @brief Adds the outcome of one game to a batch.
+ * @param stats: Batch to update.
+ * @param result: Outcome of the game.
+ */
+void addGameResult(BatchStats *stats, const GameResult *result);
+
+/**
+ * @brief Adds all games of one batch to another.
+ * @param dst: Batch to update.
+ * @param src: Batch to add.
+ */
+void mergeBatchStats(BatchStats *dst, const BatchStats *src);
+
+/**
+ * @brief Returns a monotonic timestamp in seconds.
+ * @return Seconds since an arbitrary fixed point.
+ */
+double monotonicSeconds();
+
+#endif
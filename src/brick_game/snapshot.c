@@ -0,0 +1,118 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+int takeSnapshot(const Game *tetg, Snapshot *snap) {
+  const Field *field = tetg->field;
+  if (field->height > SNAPSHOT_MAX_HEIGHT) return -1;
+
+  memset(snap, 0, sizeof(*snap));
+  int count = field->width * field->height;
+  for (int k = 0; k < count; k++)
+    snap->cells[k / 2] |= (uint8_t)((field->cells[k] & 15) << (k % 2 * 4));
+  snap->rng = tetg->rng.state;
+  snap->clock_ms = tetg->clock_ms;
+  snap->score = tetg->score;
+  snap->pieces = tetg->pieces;
+  snap->lines = tetg->lines;
+  snap->ticks_left = (int16_t)tetg->ticks_left;
+  snap->ticks = (int16_t)tetg->ticks;
+  snap->x = (int8_t)tetg->figure->x;
+  snap->y = (int8_t)tetg->figure->y;
+  snap->type = (uint8_t)tetg->figure->type;
+  snap->rot = (uint8_t)tetg->figure->rot;
+  snap->next = (uint8_t)tetg->next;
+  for (int i = 0; i < tetg->queued; i++)
+    snap->queue[i] = (uint8_t)tetg->queue[i];
+  snap->queued = (uint8_t)tetg->queued;
+  snap->bag = tetg->bag;
+  snap->level = (uint8_t)tetg->level;
+  snap->speed = (uint8_t)tetg->speed;
+  snap->pause = (uint8_t)tetg->pause;
+  snap->state = (uint8_t)tetg->state;
+  snap->action = (uint8_t)tetg->player->action;
+  return 0;
+}
+
+void restoreSnapshot(Game *tetg, const Snapshot *snap) {
+  Field *field = tetg->field;
+  for (int i = 0, k = 0; i < field->height; i++) {
+    uint16_t row = 0;
+    for (int j = 0; j < field->width; j++, k++) {
+      uint8_t id = (snap->cells[k / 2] >> (k % 2 * 4)) & 15;
+      field->cells[k] = id;
+      if (id) row |= (uint16_t)(1u << j);
+    }
+    field->rows[i] = row;
+  }
+  recountField(field);
+  tetg->rng.state = snap->rng;
+  tetg->clock_ms = (long)snap->clock_ms;
+  tetg->score = snap->score;
+  tetg->pieces = snap->pieces;
+  tetg->lines = snap->lines;
+  tetg->ticks_left = snap->ticks_left;
+  tetg->ticks = snap->ticks;
+  tetg->figure->x = snap->x;
+  tetg->figure->y = snap->y;
+  tetg->figure->type = snap->type;
+  tetg->figure->rot = snap->rot;
+  tetg->next = snap->next;
+  for (int i = 0; i < snap->queued; i++) tetg->queue[i] = snap->queue[i];
+  tetg->queued = snap->queued;
+  tetg->bag = snap->bag;
+  tetg->level = snap->level;
+  tetg->speed = snap->speed;
+  tetg->pause = snap->pause;
+  tetg->state = snap->state;
+  tetg->player->action = snap->action;
+  tetg->player->head = 0;
+  tetg->player->queued = 0;  // keys pressed before the restore are dropped
+  tetg->cleared_rows = 0;
+  tetg->events->head = tetg->events->count = 0;
+  tetg->events->overflow = false;
+  emitEvent(tetg, EVENT_RESET, 0);  // earlier events describe another game
+  tetg->generation++;
+}
+
+SnapshotRing *createSnapshotRing(int capacity) {
+  SnapshotRing *ring = (SnapshotRing *)malloc(sizeof(SnapshotRing));
+  if (ring == NULL) return NULL;
+  ring->slots = (Snapshot *)malloc(capacity * sizeof(Snapshot));
+  if (ring->slots == NULL) {
+    free(ring);
+    return NULL;
+  }
+  ring->capacity = capacity;
+  ring->head = 0;
+  ring->count = 0;
+  return ring;
+}
+
+int pushSnapshot(SnapshotRing *ring, const Game *tetg) {
+  if (takeSnapshot(tetg, &ring->slots[ring->head]) != 0) return -1;
+  ring->head = (ring->head + 1) % ring->capacity;
+  if (ring->count < ring->capacity) ring->count++;
+  return 0;
+}
+
+const Snapshot *peekSnapshot(const SnapshotRing *ring) {
+  if (ring->count == 0) return NULL;
+  return &ring->slots[(ring->head + ring->capacity - 1) % ring->capacity];
+}
+
+int popSnapshot(SnapshotRing *ring, Game *tetg) {
+  const Snapshot *snap = peekSnapshot(ring);
+  if (snap == NULL) return 0;
+  if (tetg != NULL) restoreSnapshot(tetg, snap);
+  ring->head = (ring->head + ring->capacity - 1) % ring->capacity;
+  ring->count--;
+  return 1;
+}
+
+void freeSnapshotRing(SnapshotRing *ring) {
+  if (ring) {
+    free(ring->slots);
+    free(ring);
+  }
+}
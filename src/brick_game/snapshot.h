@@ -0,0 +1,111 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "tetris.h"
+
+/**
+ * @def SNAPSHOT_MAX_HEIGHT
+ * @brief Tallest field a snapshot can hold.
+ */
+#define SNAPSHOT_MAX_HEIGHT 32
+
+/**
+ * @struct Snapshot
+ * @brief Everything that decides how a game continues, packed into a fixed
+ * size value: the field cells, the falling and next piece, the bag, the
+ * counters and the generator state. Cells are stored as piece ids, two per
+ * byte; the row words, row counts and column heights are rebuilt from them
+ * on restore. The high score and the output buffers are not part of a
+ * snapshot.
+ */
+typedef struct Snapshot {
+  uint64_t rng;
+  int64_t clock_ms;
+  uint8_t cells[SNAPSHOT_MAX_HEIGHT * FIELD_MAX_WIDTH / 2];
+  int32_t score;
+  int32_t pieces;
+  int32_t lines;
+  int16_t ticks_left;
+  int16_t ticks;
+  int8_t x;
+  int8_t y;
+  uint8_t type;
+  uint8_t rot;
+  uint8_t next;
+  uint8_t queue[BAG_SIZE];
+  uint8_t queued;
+  uint8_t bag;
+  uint8_t level;
+  uint8_t speed;
+  uint8_t pause;
+  uint8_t state;
+  uint8_t action;
+} Snapshot;
+
+/**
+ * @struct SnapshotRing
+ * @brief Fixed-capacity history of snapshots. Once full, every push
+ * overwrites the oldest entry.
+ */
+typedef struct SnapshotRing {
+  Snapshot *slots;
+  int capacity;
+  int head;  ///< slot of the next push
+  int count;
+} SnapshotRing;
+
+/**
+ * @brief Captures the state of a game.
+ * @param tetg: Game to capture.
+ * @param snap: Receives the snapshot.
+ * @return 0 on success, -1 when the field is taller than SNAPSHOT_MAX_HEIGHT.
+ */
+int takeSnapshot(const Game *tetg, Snapshot *snap);
+
+/**
+ * @brief Puts a game back into a captured state. The game must have the
+ * dimensions of the one the snapshot was taken from. The generation counter
+ * moves forward and pending events give way to a single EVENT_RESET so
+ * frontends redraw.
+ * @param tetg: Game to restore.
+ * @param snap: Snapshot to restore.
+ */
+void restoreSnapshot(Game *tetg, const Snapshot *snap);
+
+/**
+ * @brief Allocates an empty ring.
+ * @param capacity: Number of snapshots kept.
+ * @return The ring, or NULL when out of memory.
+ */
+SnapshotRing *createSnapshotRing(int capacity);
+
+/**
+ * @brief Captures a game into the ring, dropping the oldest entry when the
+ * ring is full.
+ * @param ring: Ring to push to.
+ * @param tetg: Game to capture.
+ * @return 0 on success, -1 when the game cannot be captured.
+ */
+int pushSnapshot(SnapshotRing *ring, const Game *tetg);
+
+/**
+ * @brief Returns the newest snapshot of the ring without removing it.
+ * @param ring: Ring to read.
+ * @return The snapshot, or NULL when the ring is empty.
+ */
+const Snapshot *peekSnapshot(const SnapshotRing *ring);
+
+/**
+ * @brief Removes the newest snapshot and restores it into a game.
+ * @param ring: Ring to pop from.
+ * @param tetg: Game to restore, may be NULL to only drop the snapshot.
+ * @return 1 when a snapshot was restored, 0 when the ring was empty.
+ */
+int popSnapshot(SnapshotRing *ring, Game *tetg);
+
+/**
+ * @brief Frees a ring made by createSnapshotRing().
+ * @param ring: Ring to free, may be NULL.
+ */
+void freeSnapshotRing(SnapshotRing *ring);
+
+#endif
@@ -1,28 +1,491 @@
 #include "tetris.h"
 
+#include <string.h>
+
+#include "handoff.h"
+#include "profile.h"
+#include "replay.h"
+#include "snapshot.h"
+
 #include "../gui/cli.h"
 
-int main() {
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+#define PROFILE_TEXT "profile.txt"
+#define PROFILE_JSON "profile.json"
+#define REWIND_DEPTH 1000  // pieces that can be taken back
+
+/**
+ * Writes the timing report to PROFILE_TEXT and PROFILE_JSON when profiling.
+ */
+static void dumpProfile(const Profile *profile) {
+  if (profile == NULL) return;
+  FILE *text = fopen(PROFILE_TEXT, "w");
+  if (text != NULL) {
+    writeProfileText(profile, text);
+    fclose(text);
+  }
+  FILE *json = fopen(PROFILE_JSON, "w");
+  if (json != NULL) {
+    writeProfileJson(profile, json);
+    fclose(json);
+  }
+}
+
+/**
+ * Keeps a snapshot of the spawn of every piece in history.
+ */
+static void trackHistory(Game *tetg, SnapshotRing *history) {
+  if (history == NULL) return;
+  const Snapshot *top = peekSnapshot(history);
+  if (top == NULL || top->pieces != tetg->pieces) pushSnapshot(history, tetg);
+}
+
+/**
+ * Drains the game's events. Every event changes something on screen, so
+ * there is something to draw whenever any arrived.
+ */
+static bool gameChanged(Game *tetg) {
+  GameEvent events[EVENT_QUEUE_SIZE];
+  return pollEvents(tetg, events, EVENT_QUEUE_SIZE) > 0;
+}
+
+/**
+ * Takes back the falling piece: the game returns to the spawn of the
+ * previous piece, or of the current one when there is no older snapshot.
+ */
+static void rewindPiece(Game *tetg, SnapshotRing *history) {
+  if (history == NULL) return;
+  const Snapshot *top = peekSnapshot(history);
+  if (top != NULL && top->pieces == tetg->pieces && history->count > 1)
+    popSnapshot(history, NULL);
+  if (popSnapshot(history, tetg)) startClock(tetg, monotonicMs());
+}
+
+/**
+ * Runs a key that acts on the frontend rather than on the game.
+ */
+static void runFrontendKey(Game *tetg, SnapshotRing *history,
+                           FrontendKey_t key) {
+  if (key == DumpStatsKey)
+    dumpProfile(tetg->profile);
+  else if (key == RewindKey)
+    rewindPiece(tetg, history);
+}
+
+/**
+ * Runs the frontend command of a key. Returns 1 when the key was consumed.
+ */
+static int frontendKey(Game *tetg, SnapshotRing *history, int ch) {
+  FrontendKey_t key = frontendKeyOf(ch);
+  if (key == NoFrontendKey) return 0;
+  runFrontendKey(tetg, history, key);
+  return 1;
+}
+
+/**
+ * Applies an action as soon as it is read.
+ */
+static void applyKey(Game *tetg, UserAction_t action) {
+  userInput(tetg, action, 0);
+  applyAction(tetg);
+}
+
+/**
+ * Classic loop: reads every pending key, advances one tick and sleeps out the
+ * rest of the frame. Keys are appended to rec when it is not NULL; pieces
+ * are remembered in history when it is not NULL.
+ */
+static void runFrameLoop(Game *tetg, Recorder *rec, SnapshotRing *history) {
+  Profile *profile = tetg->profile;
   struct timespec sp_start, sp_end = {0, 0};
-  srand(time(NULL));
-  initGui();
-  initGame();
+  long frame = 0;
 
   while (tetg->state != GAMEOVER) {
     clock_gettime(CLOCK_MONOTONIC, &sp_start);
-    userInput(getAction(), 0);
+    uint64_t frame_mark = profileStart(profile), mark = frame_mark;
+    int ch;
+    while (readKey(&ch)) {
+      UserAction_t action = keyAction(ch);
+      if (frontendKey(tetg, history, ch) || action == Action) continue;
+      if (rec != NULL) recordAction(rec, frame, action);
+      userInput(tetg, action, 0);
+    }
+    profileLap(profile, PHASE_INPUT, &mark);
 
-    GameInfo_t game_info = updateCurrentState();
+    GameInfo_t game_info = updateCurrentState(tetg);  // times itself
+    trackHistory(tetg, history);
+    frame++;
 
-    if (tetg->state == GAMEOVER) {
-      freeGui(game_info, tetg->figurest->size, tetg->field->height);
-      continue;
-    } else
-      printGame(game_info, sp_start, sp_end);
+    if (tetg->state != GAMEOVER) {
+      mark = profileStart(profile);
+      drawGame(game_info);
+      profileLap(profile, PHASE_RENDER, &mark);
+      handleDelay(sp_start, sp_end, game_info.speed);
+      profileLap(profile, PHASE_SLEEP, &mark);
+    }
+    profileLap(profile, PHASE_FRAME, &frame_mark);
   };
+  closeRecorder(rec, frame);
+}
+
+#ifdef __linux__
+/**
+ * Arms a one-shot timer that expires when the next gravity step is due, or
+ * stops it while the game is paused.
+ */
+static void armGravity(int tfd, const Game *tetg) {
+  long delay_ns = 0;
+  if (!tetg->pause) delay_ns = tetg->ticks_left * framePeriodNs(tetg->speed);
+  struct itimerspec its = {{0, 0},
+                           {delay_ns / 1000000000L, delay_ns % 1000000000L}};
+  timerfd_settime(tfd, 0, &its, NULL);
+}
+
+/**
+ * Event loop: sleeps in poll() until a key arrives or the gravity step is
+ * due, so a running game wakes once per step plus once per key. The timer
+ * is re-armed after each step and whenever a key pauses or resumes the
+ * game, spawns a piece or changes the level.
+ * @return false when no timer could be created.
+ */
+static bool runEventLoop(Game *tetg, SnapshotRing *history) {
+  int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (tfd < 0) return false;
+  struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {tfd, POLLIN, 0}};
+  Profile *profile = tetg->profile;
+  int armed_pause = -1, armed_speed = -1, armed_pieces = -1;
+
+  GameView view = viewGame(tetg);
+  gameChanged(tetg);
+  drawView(&view);
+  while (tetg->state != GAMEOVER) {
+    uint64_t frame_mark = profileStart(profile), mark = frame_mark;
+    if (tetg->pause != armed_pause || tetg->speed != armed_speed ||
+        tetg->pieces != armed_pieces) {
+      armGravity(tfd, tetg);
+      armed_pause = tetg->pause;
+      armed_speed = tetg->speed;
+      armed_pieces = tetg->pieces;
+    }
+    if (poll(fds, 2, -1) < 0) continue;
+    profileLap(profile, PHASE_SLEEP, &mark);
+
+    int ch;
+    while (tetg->state != GAMEOVER && readKey(&ch))
+      if (!frontendKey(tetg, history, ch)) applyKey(tetg, keyAction(ch));
+    profileLap(profile, PHASE_INPUT, &mark);
+
+    uint64_t expired = 0;
+    if ((fds[1].revents & POLLIN) && read(tfd, &expired, sizeof(expired)) > 0 &&
+        !tetg->pause && tetg->state != GAMEOVER) {
+      calcOne(tetg);
+      armed_pieces = -1;  // the next step is a full interval away
+    }
+    trackHistory(tetg, history);
+    profileLap(profile, PHASE_SIMULATE, &mark);
+
+    if (tetg->state != GAMEOVER && gameChanged(tetg)) {
+      view = viewGame(tetg);
+      profileLap(profile, PHASE_EXPORT, &mark);
+      drawView(&view);
+      profileLap(profile, PHASE_RENDER, &mark);
+    }
+    profileLap(profile, PHASE_FRAME, &frame_mark);
+  }
+  close(tfd);
+  return true;
+}
+#endif
+
+/**
+ * Fixed-timestep loop: gravity follows the monotonic clock and the level's
+ * interval, whatever the frame rate. Keys are applied when they arrive, the
+ * screen is drawn only when the game changed, and the loop sleeps in poll()
+ * until the next key or gravity step.
+ */
+static void runFixedLoop(Game *tetg, SnapshotRing *history) {
+  Profile *profile = tetg->profile;
+
+  startClock(tetg, monotonicMs());
+  while (tetg->state != GAMEOVER) {
+    uint64_t frame_mark = profileStart(profile), mark = frame_mark;
+    long now = monotonicMs();
+    int was_paused = tetg->pause;
+    int ch;
+    while (tetg->state != GAMEOVER && readKey(&ch))
+      if (!frontendKey(tetg, history, ch)) applyKey(tetg, keyAction(ch));
+    resumeClock(tetg, was_paused, now);
+    profileLap(profile, PHASE_INPUT, &mark);
+    advanceClock(tetg, now);
+    trackHistory(tetg, history);
+    profileLap(profile, PHASE_SIMULATE, &mark);
+    if (tetg->state == GAMEOVER) break;
+
+    if (gameChanged(tetg)) {
+      GameView view = viewGame(tetg);
+      profileLap(profile, PHASE_EXPORT, &mark);
+      drawView(&view);
+      profileLap(profile, PHASE_RENDER, &mark);
+    }
+    struct pollfd in = {STDIN_FILENO, POLLIN, 0};
+    poll(&in, 1, (int)nextStepDelay(tetg, monotonicMs()));
+    profileLap(profile, PHASE_SLEEP, &mark);
+    profileLap(profile, PHASE_FRAME, &frame_mark);
+  }
+}
+
+/**
+ * State shared by the threads of the threaded loop. The pipes only wake
+ * threads up; the data goes through input and frames.
+ */
+typedef struct Threads {
+  InputRing input;
+  TripleBuffer *frames;
+  atomic_bool running;
+  int wake_sim[2];
+  int wake_render[2];
+  Histogram render;  ///< written by the render thread only
+  atomic_int frontend_keys[FRONTEND_KEYS];  ///< presses the simulation runs
+} Threads;
+
+/**
+ * Sends a wake-up byte. A full pipe already holds one, so errors are
+ * ignored.
+ */
+static void wake(int fd) {
+  char byte = 0;
+  if (write(fd, &byte, 1) < 0) return;
+}
+
+/**
+ * Reads all pending wake-up bytes.
+ */
+static void drainWakes(int fd) {
+  char bytes[64];
+  while (read(fd, bytes, sizeof(bytes)) > 0) continue;
+}
+
+/**
+ * Input thread: reads raw key bytes from the terminal, maps them like
+ * getAction() and queues them for the simulation.
+ */
+static void *inputThread(void *arg) {
+  Threads *threads = (Threads *)arg;
+  struct pollfd in = {STDIN_FILENO, POLLIN, 0};
+  while (atomic_load(&threads->running)) {
+    if (poll(&in, 1, 50) <= 0) continue;  // the timeout rechecks running
+    unsigned char keys[64];
+    ssize_t count = read(STDIN_FILENO, keys, sizeof(keys));
+    for (ssize_t i = 0; i < count; i++) {
+      int ch = keys[i] == '\r' ? '\n' : keys[i];
+      UserAction_t action = keyAction(ch);
+      FrontendKey_t key = frontendKeyOf(ch);
+      if (key != NoFrontendKey)
+        atomic_fetch_add(&threads->frontend_keys[key], 1);
+      else if (action != Action)
+        pushInput(&threads->input, action);
+    }
+    if (count > 0) wake(threads->wake_sim[1]);
+  }
+  return NULL;
+}
+
+/**
+ * Render thread: draws the newest published state whenever the simulation
+ * signals one, skipping the states it was too slow to show.
+ */
+static void *renderThread(void *arg) {
+  Threads *threads = (Threads *)arg;
+  struct pollfd in = {threads->wake_render[0], POLLIN, 0};
+  while (atomic_load(&threads->running)) {
+    if (poll(&in, 1, -1) <= 0) continue;
+    drainWakes(threads->wake_render[0]);
+    GameInfo_t game_info;
+    if (!atomic_load(&threads->running) ||
+        !latestState(threads->frames, &game_info))
+      continue;
+    uint64_t start = monotonicNs();
+    drawGame(game_info);
+    recordLatency(&threads->render, monotonicNs() - start);
+  }
+  return NULL;
+}
+
+/**
+ * Creates a pipe whose ends never block.
+ */
+static int wakePipe(int fds[2]) {
+  if (pipe(fds) != 0) return -1;
+  for (int i = 0; i < 2; i++)
+    fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+  return 0;
+}
+
+/**
+ * Closes the wake-up pipes and frees the frames of a threaded loop.
+ */
+static void closeThreads(Threads *threads) {
+  for (int i = 0; i < 2; i++) {
+    if (threads->wake_sim[i] >= 0) close(threads->wake_sim[i]);
+    if (threads->wake_render[i] >= 0) close(threads->wake_render[i]);
+  }
+  freeTripleBuffer(threads->frames);
+}
+
+/**
+ * Threaded loop: an input thread feeds keys through a lock-free queue, this
+ * thread owns the game and runs it on the fixed timestep, and a render
+ * thread draws the newest state taken from a triple buffer. A slow terminal
+ * only delays the render thread, never gravity or input.
+ * @return false when the threads could not be set up; the game is untouched.
+ */
+static bool runThreadedLoop(Game *tetg, SnapshotRing *history) {
+  Profile *profile = tetg->profile;
+  Threads threads;
+  initInputRing(&threads.input);
+  atomic_init(&threads.running, true);
+  threads.render = (Histogram){0};
+  for (int key = 0; key < FRONTEND_KEYS; key++)
+    atomic_init(&threads.frontend_keys[key], 0);
+  for (int i = 0; i < 2; i++) threads.wake_sim[i] = threads.wake_render[i] = -1;
+  threads.frames = createTripleBuffer(tetg->field->width, tetg->field->height,
+                                      tetg->figurest->size);
+  if (threads.frames == NULL || wakePipe(threads.wake_sim) != 0 ||
+      wakePipe(threads.wake_render) != 0) {
+    closeThreads(&threads);
+    return false;
+  }
+
+  pthread_t input, render;
+  if (pthread_create(&input, NULL, inputThread, &threads) != 0) {
+    closeThreads(&threads);
+    return false;
+  }
+  if (pthread_create(&render, NULL, renderThread, &threads) != 0) {
+    atomic_store(&threads.running, false);
+    pthread_join(input, NULL);
+    closeThreads(&threads);
+    return false;
+  }
+
+  unsigned long published = tetg->generation - 1;
+  struct pollfd in = {threads.wake_sim[0], POLLIN, 0};
+  startClock(tetg, monotonicMs());
+  while (tetg->state != GAMEOVER) {
+    uint64_t frame_mark = profileStart(profile), mark = frame_mark;
+    long now = monotonicMs();
+    drainWakes(threads.wake_sim[0]);
+    int was_paused = tetg->pause;
+    UserAction_t action;
+    while (tetg->state != GAMEOVER && popInput(&threads.input, &action))
+      applyKey(tetg, action);
+    for (int key = 0; key < FRONTEND_KEYS; key++)
+      for (int n = atomic_exchange(&threads.frontend_keys[key], 0); n > 0; n--)
+        runFrontendKey(tetg, history, (FrontendKey_t)key);
+    resumeClock(tetg, was_paused, now);
+    profileLap(profile, PHASE_INPUT, &mark);
+    advanceClock(tetg, now);
+    trackHistory(tetg, history);
+    profileLap(profile, PHASE_SIMULATE, &mark);
+    if (tetg->state == GAMEOVER) break;
+
+    if (tetg->generation != published) {
+      publishState(threads.frames, exportCurrentState(tetg));
+      wake(threads.wake_render[1]);
+      published = tetg->generation;
+      profileLap(profile, PHASE_EXPORT, &mark);
+    }
+    poll(&in, 1, (int)nextStepDelay(tetg, monotonicMs()));
+    profileLap(profile, PHASE_SLEEP, &mark);
+    profileLap(profile, PHASE_FRAME, &frame_mark);
+  }
+
+  atomic_store(&threads.running, false);
+  wake(threads.wake_render[1]);
+  pthread_join(input, NULL);
+  pthread_join(render, NULL);
+  if (profile != NULL) profile->phases[PHASE_RENDER] = threads.render;
+  closeThreads(&threads);
+  return true;
+}
+
+typedef enum { FRAME_LOOP, EVENT_LOOP, FIXED_LOOP, THREADED_LOOP } LoopMode;
+
+int main(int argc, char **argv) {
+  LoopMode mode = FRAME_LOOP;
+  const char *record = NULL;
+  bool profiling = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--event") == 0) mode = EVENT_LOOP;
+    if (strcmp(argv[i], "--fixed") == 0) mode = FIXED_LOOP;
+    if (strcmp(argv[i], "--threaded") == 0) mode = THREADED_LOOP;
+    if (strcmp(argv[i], "--profile") == 0) profiling = true;
+    if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) record = argv[++i];
+  }
+
+  uint64_t seed = (uint64_t)time(NULL);
+  Recorder *rec = NULL;
+  if (record != NULL) {
+    rec = openRecorder(record, seed, false);
+    if (rec == NULL) {
+      perror(record);
+      return 1;
+    }
+    mode = FRAME_LOOP;  // replays count frames, so record in the frame loop
+  }
+
+  Leaderboard board;
+  int high_score = loadHighScore(&board, HIGH_SCORE_FILE);
+
+  Game *tetg = initGame(seed, false);
+  if (tetg == NULL) {
+    fprintf(stderr, "tetris: out of memory\n");
+    if (rec != NULL) closeRecorder(rec, 0);
+    return 1;
+  }
+  initGui();
+  tetg->high_score = high_score;
+  Profile profile = {0};
+  if (profiling) tetg->profile = &profile;
+  // a rewound game could not be replayed from its inputs
+  SnapshotRing *history = rec == NULL ? createSnapshotRing(REWIND_DEPTH) : NULL;
+  trackHistory(tetg, history);
+
+  switch (mode) {
+#ifdef __linux__
+    case EVENT_LOOP:
+      if (!runEventLoop(tetg, history)) runFrameLoop(tetg, NULL, history);
+      break;
+#endif
+    case FIXED_LOOP:
+      runFixedLoop(tetg, history);
+      break;
+    case THREADED_LOOP:
+      if (!runThreadedLoop(tetg, history)) runFixedLoop(tetg, history);
+      break;
+    default:
+      runFrameLoop(tetg, rec, history);
+      break;
+  }
+  const char *name = getenv("USER");
+  if (tetg->score > 0 && submitScore(&board, name ? name : "player",
+                                     tetg->score, tetg->level, time(NULL)) >= 0)
+    saveHighScore(&board, HIGH_SCORE_FILE);
+  freeSnapshotRing(history);
   freeGame(tetg);
 
   endwin();
+  if (profiling) {
+    dumpProfile(&profile);
+    writeProfileText(&profile, stdout);
+  }
 
   return 0;
 }
@@ -51,7 +514,9 @@ such as score counting, level progression, and high score tracking.
     - Move left -  left arrow
     - Move right -  right arrow
     - Move down - down arrow
+    - Hard drop - up arrow
     - Rotate - Space
+    - Take back the last piece - 'r'
  *- Matrix-based game field with dimensions corresponding to the console's
 size (10x20 pixels)
  *- Proper stopping of tetrominoes after reaching the bottom or colliding with
@@ -91,9 +556,12 @@ game sessions
  *
  * ## Usage
  *
-- Use the arrow keys to move and rotate tetrominoes.
+- Use the left and right arrow keys to move tetrominoes and Space to rotate
+them.
 - Press the down arrow key to make tetrominoes fall faster.
-- Press the up arrow key to rotate tetrominoes.
+- Press the up arrow key to drop a tetromino at once (hard drop).
+- Press 'r' to take back the last piece, and 's' to write the timing report
+when running with `--profile`.
  *
  * ## Fsm Finite State Machine (FSM) Diagram
  * A diagram showing the FSM used in the game logic.
@@ -2,6 +2,8 @@
 #define TETRIS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -18,7 +20,8 @@ typedef enum {
   Right,
   Up,
   Down,
-  Action
+  Action,
+  HardDrop
 } UserAction_t;
 
 /**
@@ -30,15 +33,25 @@ typedef enum { INIT, DROP, MOVING, COLLISION, PAUSE, GAMEOVER } GameState;
 /**
  * @struct GameInfo_t
  * @brief Holds the dynamic information about the game's current state.
+ * field and next point into buffers owned by the game: they stay valid until
+ * the second following updateCurrentState() call or until freeGame(), and
+ * must not be freed or kept longer by the frontend. Bit i of cleared_rows is
+ * set when row i of the previous frame was cleared since the last export.
+ * ghost_row is the top field row of the falling figure once dropped. Cells
+ * are bytes and the cells of each buffer are contiguous, row after row. A
+ * cell is 0 when empty and the piece id (template index + 1, as in
+ * Field::cells) of the piece that filled it otherwise.
  */
 typedef struct {
-  int **field;
-  int **next;
+  uint8_t **field;
+  uint8_t **next;
   int score;
   int high_score;
   int level;
   int speed;
   int pause;
+  uint32_t cleared_rows;
+  int ghost_row;
 } GameInfo_t;
 
 /**
@@ -46,18 +59,41 @@ typedef struct {
  * @brief Represents a single block in the game.
  */
 typedef struct Block {
-  int b;
+  uint8_t b;
 } Block;
 
+/**
+ * @def FIELD_MAX_WIDTH
+ * @brief Widest field that fits into one row word of the bitboard.
+ */
+#define FIELD_MAX_WIDTH 16
+
+/**
+ * @struct Shape
+ * @brief One rotation of a figure template clipped to its bounding box. Bit c
+ * of rows[r] is set when the box has a block at column c of row r; skirt[c]
+ * is the lowest row of the box with a block in column c.
+ */
+typedef struct Shape {
+  int8_t dx;
+  int8_t dy;
+  uint8_t w;
+  uint8_t h;
+  uint16_t rows[4];
+  int8_t skirt[4];
+} Shape;
+
 /**
  * @struct Figure
- * @brief Represents a game figure composed of multiple blocks.
+ * @brief Represents the falling figure as a template index and a rotation
+ * index into the precomputed shape table. x and y locate the template frame;
+ * the shape is drawn at (x + dx, y + dy).
  */
 typedef struct Figure {
   int x;
   int y;
-  int size;
-  Block **blocks;
+  int type;
+  int rot;
 } Figure;
 
 /**
@@ -72,32 +108,143 @@ typedef struct FiguresT {
 
 /**
  * @struct Field
- * @brief Represents the playing field.
+ * @brief Represents the playing field as a bitboard: one word per row, bit j
+ * of rows[i] is set when the cell at column j of row i is occupied. fill[i]
+ * counts the occupied cells of row i and heights[j] is the height of the
+ * highest occupied cell of column j (0 for an empty column); both are kept
+ * up to date by every engine function that changes the field. cells holds
+ * the piece id of every cell, row after row (cells[i * width + j]): 0 when
+ * empty, the template index + 1 when occupied. The rows stay the reference
+ * for occupancy; cells only tells pieces apart.
  */
 typedef struct Field {
   int width;
   int height;
-  Block **blocks;
+  uint16_t full;
+  uint16_t *rows;
+  uint8_t *fill;
+  uint8_t *heights;
+  uint8_t *cells;
 } Field;
 
+/**
+ * @struct Arena
+ * @brief Bump allocator over the single block that holds a whole game.
+ */
+typedef struct Arena {
+  char *base;
+  size_t used;
+  size_t size;
+} Arena;
+
+/**
+ * @def INPUT_QUEUE_SIZE
+ * @brief Number of key presses that can wait for the next tick.
+ */
+#define INPUT_QUEUE_SIZE 16
+
+/**
+ * @struct InputEvent
+ * @brief One key press and the monotonic time it was queued at.
+ */
+typedef struct InputEvent {
+  uint64_t time_ns;
+  int action;
+} InputEvent;
+
 /**
  * @struct Player
- * @brief Represents the player's current action.
+ * @brief Represents the player's input: the key presses waiting to be
+ * applied, oldest first from queue[head], and the last applied action.
  */
 typedef struct Player {
   int action;
+  InputEvent queue[INPUT_QUEUE_SIZE];
+  int head;
+  int queued;
 } Player;
 
+/**
+ * @def EVENT_QUEUE_SIZE
+ * @brief Number of game events kept until a frontend polls them.
+ */
+#define EVENT_QUEUE_SIZE 64
+
+/**
+ * @enum GameEventType
+ * @brief What a GameEvent reports.
+ */
+typedef enum {
+  EVENT_RESET,     ///< events were lost or the game was replaced: redraw all
+  EVENT_SPAWN,     ///< a new figure appeared, value is the next piece type
+  EVENT_MOVE,      ///< the figure moved to x, y
+  EVENT_ROTATE,    ///< the figure turned to rot
+  EVENT_PLANT,     ///< the figure became part of the field
+  EVENT_CLEAR,     ///< rows were erased, value has bit i set for each row i
+  EVENT_SCORE,     ///< the score changed to value
+  EVENT_LEVEL,     ///< the level (and speed) changed to value
+  EVENT_PAUSE,     ///< value is 1 when the game paused, 0 when it resumed
+  EVENT_GAMEOVER,  ///< the game ended
+} GameEventType;
+
+/**
+ * @struct GameEvent
+ * @brief One change of the game, with the falling figure as it was right
+ * after the change.
+ */
+typedef struct GameEvent {
+  uint8_t type;  ///< GameEventType
+  uint8_t piece;
+  uint8_t rot;
+  int8_t x;
+  int8_t y;
+  int32_t value;
+} GameEvent;
+
+/**
+ * @struct EventQueue
+ * @brief Events the game emitted since the last pollEvents(), oldest first
+ * from events[head]. Once full, new events are dropped and the next poll
+ * reports a single EVENT_RESET instead.
+ */
+typedef struct EventQueue {
+  GameEvent events[EVENT_QUEUE_SIZE];
+  int head;
+  int count;
+  bool overflow;
+} EventQueue;
+
+/**
+ * @def BAG_SIZE
+ * @brief Capacity of the preview queue filled by the 7-bag generator.
+ */
+#define BAG_SIZE 7
+
+/**
+ * @struct Rng
+ * @brief State of a PCG32 pseudo-random generator.
+ */
+typedef struct Rng {
+  uint64_t state;
+} Rng;
+
 /**
  * @struct Game
- * @brief Main game structure holding all game-related data.
+ * @brief Main game structure holding all game-related data. A game is one
+ * allocation of arena_size bytes: the Game itself comes first and every
+ * structure it points to (field, figure slot, player, templates, output
+ * buffers) is carved from the rest of the block.
  */
 typedef struct Game {
   Field *field;
   Figure *figure;
   FiguresT *figurest;
   Player *player;
+  EventQueue *events;
   Block **tet_templates;
+  uint8_t **print_field[2];
+  uint8_t **print_next[2];
+  int buffer;
 
   int score;
   int high_score;
@@ -106,22 +253,68 @@ typedef struct Game {
   int speed;
   int level;
   int next;
+  int pieces;
+  int lines;
+  uint32_t cleared_rows;
+
+  Rng rng;
+  bool bag;
+  int queue[BAG_SIZE];
+  int queued;
 
   int pause;
   int state;
 
+  long clock_ms;
+  unsigned long generation;
+
+  struct Profile *profile;  ///< phase timers, NULL unless profiling
+  size_t arena_size;
 } Game;
 
+/**
+ * @struct GameView
+ * @brief Read-only view of a game that points into the engine's own storage
+ * instead of copying it. rows and cells are the live field (see Field);
+ * piece and shape describe the falling figure, which is not part of the
+ * field and is drawn over it at (piece.x + shape->dx, piece.y + shape->dy).
+ * generation changes whenever the game does, so a frontend can skip frames
+ * it has already drawn. The pointers stay valid until freeGame() but the
+ * data behind them changes with the game.
+ */
+typedef struct GameView {
+  const uint16_t *rows;
+  const uint8_t *cells;
+  int width;
+  int height;
+  Figure piece;
+  const Shape *shape;
+  const Shape *next_shape;  ///< spawn rotation of the next figure
+  int next;
+  int ghost_row;
+  int score;
+  int high_score;
+  int level;
+  int speed;
+  int pause;
+  unsigned long generation;
+} GameView;
+
 /**
  *@brief Initialization of the game.
  * Program starts here
+ * @param seed: Seed of the game's piece generator.
+ * @param bag: true to deal pieces from shuffled bags of all templates, false
+ * to pick every piece independently.
+ * @return A new game waiting for Start, released with freeGame(), or NULL
+ * when out of memory.
  */
-void initGame();
+Game *initGame(uint64_t seed, bool bag);
 
 /**
  * @brief Creates and initializes the main game structure (Game). It sets up the
  game field, figures templates, and initializes game parameters like score, high
- score, and game state.
+ score, and game state. Everything is placed in one zeroed allocation.
  * @param field_width: The width of the game field.
  * @param field_height: The height of the game field.
  * @param figures_size: The size of the figures.
@@ -132,62 +325,153 @@ Game *createGame(int field_width, int field_height, int figures_size,
                  int count);
 
 /**
- * @brief  Allocates and initializes the game field with the specified
- * dimensions.
- * @param width: The width of the game field.
+ * @brief Copies a game into a new allocation of its own. The copy shares no
+ * memory with the original and is released with freeGame(); it is not
+ * attached to the original's profile.
+ * @param tetg: Game to copy.
+ * @return The copy, or NULL when out of memory.
+ */
+Game *cloneGame(const Game *tetg);
+
+/**
+ * @brief Number of bytes of the block holding a game of these dimensions.
+ * @param field_width: The width of the game field.
+ * @param field_height: The height of the game field.
+ * @param figures_size: The size of the figures.
+ * @return Size of the allocation made by createGame().
+ */
+size_t gameArenaSize(int field_width, int field_height, int figures_size);
+
+/**
+ * @brief Takes the next suitably aligned piece of an arena.
+ * @param arena: Arena to carve from.
+ * @param size: Bytes needed.
+ * @return The piece, or NULL when the arena is exhausted.
+ */
+void *arenaAlloc(Arena *arena, size_t size);
+
+/**
+ * @brief  Carves the game field with the specified dimensions from an arena.
+ * The cells are left as they are in the arena memory.
+ * @param arena: Arena holding the game.
+ * @param width: The width of the game field, at most FIELD_MAX_WIDTH.
  * @param height: The height of the game field.
- * @return A pointer to the initialized Field structure.
+ * @return A pointer to the Field structure.
  */
-Field *createField(int width, int height);
+Field *createField(Arena *arena, int width, int height);
 
 /**
- * @brief  Initializes the templates for the Tetris figures using predefined
- * figure arrays.
+ * @brief  Carves the table of template pointers from an arena and points it
+ * at the predefined figure arrays.
+ * @param arena: Arena holding the game.
  * @return An array of pointers to Block, representing different figure
  * templates.
  */
-Block **createTemplates();
+Block **createTemplates(Arena *arena);
 
 /**
- * @brief  Creates and initializes the structure holding the figures templates
- * and their metadata.
+ * @brief  Carves the structure holding the figures templates and their
+ * metadata from an arena.
+ * @param arena: Arena holding the game.
  * @param count: Number of different figures.
  * @param figures_size: Size of each figure.
  * @param figures_template: Pointer to the array of figure templates.
  * @return A pointer to the initialized FiguresT structure.
  */
-FiguresT *createFiguresT(int count, int figures_size, Block **figures_template);
+FiguresT *createFiguresT(Arena *arena, int count, int figures_size,
+                         Block **figures_template);
 
 /**
- * @brief Allocates memory for a new figure and initializes its blocks to zero.
+ * @brief Resets the game's figure slot to a new figure of the next template,
+ * placed at the top center of the field in its spawn rotation.
  * @param tetg: Pointer to the game state.
- * @return Pointer to the newly created figure.
+ * @return Pointer to the figure slot.
  */
 Figure *createFigure(Game *tetg);
 
 /**
- * @brief Creates a printable representation of the current game field.
+ * @brief Carves a buffer for the printable game field from an arena. The
+ * cells are contiguous, row after row.
+ * @param arena: Arena holding the game.
  * @param width: Width of the field.
  * @param height: Height of the field.
- * @return 2D array of integers representing the field state.
+ * @return 2D array of byte cells for the field state.
  */
-int **createPrintField(int width, int height);
+uint8_t **createPrintField(Arena *arena, int width, int height);
 
 /**
- * @brief Generates the next block to be played, based on the current game
- * state.
+ * @brief Carves a buffer for the printable next block from an arena.
+ * @param arena: Arena holding the game.
  * @param size: Size of the block.
- * @return 2D array of integers representing the next block.
+ * @return 2D array of byte cells for the next block.
+ */
+uint8_t **createNextBlock(Arena *arena, int size);
+
+/**
+ * @brief Writes the current field with the falling figure into a buffer made
+ * by createPrintField().
+ * @param tetg: Pointer to the game state.
+ * @param print_field: Buffer to fill.
+ */
+void fillPrintField(Game *tetg, uint8_t **print_field);
+
+/**
+ * @brief Writes the next figure template into a buffer made by
+ * createNextBlock().
+ * @param tetg: Pointer to the game state.
+ * @param next: Buffer to fill.
+ */
+void fillNextBlock(Game *tetg, uint8_t **next);
+
+/**
+ * @brief Seeds a PCG32 generator.
+ * @param rng: Generator to seed.
+ * @param seed: Any 64-bit value; equal seeds give equal sequences.
  */
-int **createNextBlock(int size);
+void seedRng(Rng *rng, uint64_t seed);
 
 /**
- * @brief Processes user input and updates the player's action in the game
- * structure.
+ * @brief Advances a PCG32 generator.
+ * @param rng: Generator to advance.
+ * @return The next 32 random bits.
+ */
+uint32_t nextRandom(Rng *rng);
+
+/**
+ * @brief Draws a uniform random number below a bound.
+ * @param rng: Generator to advance.
+ * @param bound: Exclusive upper bound, greater than zero.
+ * @return A number in [0, bound).
+ */
+uint32_t randomBelow(Rng *rng, uint32_t bound);
+
+/**
+ * @brief Reseeds the piece generator of a game, empties its preview queue and
+ * draws a new next figure.
+ * @param tetg: Pointer to the game state.
+ * @param seed: Seed of the piece generator.
+ * @param bag: true for the 7-bag generator, false for independent picks.
+ */
+void seedGame(Game *tetg, uint64_t seed, bool bag);
+
+/**
+ * @brief Draws the template index of the next figure. In bag mode the
+ * preview queue is refilled with a shuffled bag of every template whenever
+ * it runs empty.
+ * @param tetg: Pointer to the game state.
+ * @return Template index of the figure.
+ */
+int nextFigureType(Game *tetg);
+
+/**
+ * @brief Queues a key press, stamped with the monotonic clock, to be applied
+ * in order by the next applyAction() or calculate(). Action (no key) and
+ * held keys are not queued; when the queue is full the press is dropped.
+ * @param tetg: Pointer to the game state.
  * @param action: The action performed by the user.
  * @param hold: Indicates whether the action is being held down.
  */
-void userInput(UserAction_t action, bool hold);
+void userInput(Game *tetg, UserAction_t action, bool hold);
 
 /**
  * @brief Initializes a new figure in the game, sets its starting position,
@@ -198,10 +482,57 @@ void dropNewFigure(Game *tetg);
 
 /**
  * @brief Updates and returns the current state of the game, including field and
- * next block representations.
+ * next block representations. The field and next block are written into the
+ * game's two alternating output buffers, so no memory is allocated.
+ * @param tetg: Pointer to the game state.
+ * @return GameInfo_t structure containing the current game state.
+ */
+GameInfo_t updateCurrentState(Game *tetg);
+
+/**
+ * @brief Fills the next output buffer with the current state without
+ * advancing the game.
+ * @param tetg: Pointer to the game state.
  * @return GameInfo_t structure containing the current game state.
  */
-GameInfo_t updateCurrentState();
+GameInfo_t exportCurrentState(Game *tetg);
+
+/**
+ * @brief Adds an event to the game's queue, filled in with the current
+ * figure.
+ * @param tetg: Pointer to the game state.
+ * @param type: GameEventType of the event.
+ * @param value: Meaning depends on the type, see GameEventType.
+ */
+void emitEvent(Game *tetg, int type, int32_t value);
+
+/**
+ * @brief Takes the oldest events off the game's queue. A frontend that
+ * polls every frame learns what changed without comparing whole frames.
+ * @param tetg: Pointer to the game state.
+ * @param out: Where to copy the events.
+ * @param max: Room in out.
+ * @return Number of events copied.
+ */
+int pollEvents(Game *tetg, GameEvent *out, int max);
+
+/**
+ * @brief Describes the current state without copying the field. Costs the
+ * same whatever the field size; see GameView for how long it stays valid.
+ * @param tetg: Pointer to the game state.
+ * @return View of the game.
+ */
+GameView viewGame(const Game *tetg);
+
+/**
+ * @brief Reads a cell of a view with the falling figure drawn over the
+ * field.
+ * @param view: View to read.
+ * @param y: Row of the cell.
+ * @param x: Column of the cell.
+ * @return 0 for an empty cell, otherwise the piece id.
+ */
+int viewCell(const GameView *view, int y, int x);
 
 /**
  * @brief Processes one tick of the game logic, handling user actions and game
@@ -210,6 +541,71 @@ GameInfo_t updateCurrentState();
  */
 void calculate(Game *tetg);
 
+/**
+ * @brief Applies every queued key press in order (move, rotate, drop, pause,
+ * start or terminate) without advancing gravity, and leaves the last one in
+ * player->action.
+ * @param tetg: Pointer to the game structure.
+ */
+void applyAction(Game *tetg);
+
+/**
+ * @def MAX_CATCHUP_STEPS
+ * @brief Most gravity steps advanceClock() runs to catch up with a late
+ * frame; time beyond that is dropped.
+ */
+#define MAX_CATCHUP_STEPS 8
+
+/**
+ * @brief Returns the gravity interval of a level, from 800 ms at level 1 down
+ * to 100 ms at level 10.
+ * @param level: Game level.
+ * @return Milliseconds between two gravity steps.
+ */
+int gravityInterval(int level);
+
+/**
+ * @brief Starts the simulation clock of a game at the given time.
+ * @param tetg: Pointer to the game structure.
+ * @param now_ms: Current monotonic time in milliseconds.
+ */
+void startClock(Game *tetg, long now_ms);
+
+/**
+ * @brief Restarts the clock when keys have just resumed the game. A frontend
+ * that sleeps without a timeout while paused or on the title screen calls
+ * this after applying keys, so the wait is not made up with a burst of
+ * gravity steps.
+ * @param tetg: Pointer to the game structure.
+ * @param was_paused: tetg->pause before the keys were applied.
+ * @param now_ms: Current monotonic time in milliseconds.
+ */
+void resumeClock(Game *tetg, int was_paused, long now_ms);
+
+/**
+ * @brief Runs every gravity step that is due at now_ms, at most
+ * MAX_CATCHUP_STEPS of them. While the game is paused the clock just follows
+ * the current time.
+ * @param tetg: Pointer to the game structure.
+ * @param now_ms: Current monotonic time in milliseconds.
+ * @return Number of gravity steps run.
+ */
+int advanceClock(Game *tetg, long now_ms);
+
+/**
+ * @brief Tells how long the frontend may wait before the next gravity step.
+ * @param tetg: Pointer to the game structure.
+ * @param now_ms: Current monotonic time in milliseconds.
+ * @return Milliseconds until the next step, or -1 while the game is paused.
+ */
+long nextStepDelay(const Game *tetg, long now_ms);
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Current monotonic time in milliseconds.
+ */
+long monotonicMs();
+
 /**
  * @brief Handles the logic for one game tick, moving the figure down and
  * checking for collisions.
@@ -249,9 +645,27 @@ void moveFigureLeft(Game *tetg);
  */
 int collision(Game *tetg);
 
+/**
+ * @brief Counts how many rows the current figure can fall before it lands.
+ * Reads the column heights when the figure is above the surface and only
+ * probes row by row when it is tucked under an overhang.
+ * @param tetg: Pointer to the game state.
+ * @return Number of free rows below the figure.
+ */
+int dropDistance(const Game *tetg);
+
+/**
+ * @brief Moves the current figure straight down to where it lands and plants
+ * it at once, spawning the next figure.
+ * @param tetg: Pointer to the game state.
+ */
+void hardDrop(Game *tetg);
+
 /**
  * @brief Checks for filled lines in the field and removes them, moving all
- * above lines down.
+ * above lines down in a single bottom-up pass. Bit i of tetg->cleared_rows is
+ * set for every cleared row i (rows below 32 only) until the next
+ * exportCurrentState(), and EVENT_CLEAR reports the same rows.
  * @param tetg: Pointer to the game state.
  * @return The number of lines erased.
  */
@@ -274,22 +688,55 @@ int lineFilled(int i, Field *tfl);
 void dropLine(int i, Field *tfl);
 
 /**
- * @brief Creates a new figure as a rotated version of the current figure.
+ * @brief Sets or clears a single cell of the field.
+ * @param tfl: Pointer to the field.
+ * @param y: Row of the cell.
+ * @param x: Column of the cell.
+ * @param b: Piece id to occupy the cell with, zero to clear it.
+ */
+void setBlock(Field *tfl, int y, int x, int b);
+
+/**
+ * @brief Recomputes the row fill counts and column heights from the row
+ * words, for code that writes field->rows directly. Cells that the rows
+ * leave empty are cleared and newly occupied cells get piece id 1.
+ * @param tfl: Pointer to the field.
+ */
+void recountField(Field *tfl);
+
+/**
+ * @brief Reads a single cell of the field.
+ * @param tfl: Pointer to the field.
+ * @param y: Row of the cell.
+ * @param x: Column of the cell.
+ * @return 1 if the cell is occupied, otherwise 0.
+ */
+int getBlock(const Field *tfl, int y, int x);
+
+/**
+ * @brief Returns the shape of a figure in its current rotation.
+ * @param figure: Pointer to the figure.
+ * @return Pointer to the entry of the shape table.
+ */
+const Shape *figureShape(const Figure *figure);
+
+/**
+ * @brief Rotates the current figure a quarter turn counterclockwise in place.
  * @param tetg: Pointer to the game state.
- * @return Pointer to the rotated figure.
+ * @param dir: 1 to rotate, -1 to undo a previous rotation.
  */
-Figure *rotFigure(Game *tetg);
+void rotFigure(Game *tetg, int dir);
 
 /**
  * @brief Attempts to rotate the current figure and checks for collisions.
- * Reverts if a collision occurs.
+ * Reverts if a collision occurs, otherwise emits EVENT_ROTATE.
  * @param tetg: Pointer to the game state.
  */
 void handleRotation(Game *tetg);
 
 /**
  * @brief Places the current figure's blocks into the game field if they are
- * within bounds.
+ * within bounds, tagging the cells with the figure's piece id.
  * @param tetg: Pointer to the game state.
  */
 void plantFigure(Game *tetg);
@@ -302,74 +749,83 @@ void plantFigure(Game *tetg);
 void countScore(Game *tetg);
 
 /**
- * @brief Saves the high score to a file.
- * @param high_score: The high score to save.
+ * @def HIGH_SCORE_FILE
+ * @brief Default leaderboard file, relative to the working directory.
  */
-void saveHighScore(int high_score);
+#define HIGH_SCORE_FILE "high_score.dat"
 
 /**
- * @brief Loads the high score from a file.
- * @return The high score as an integer.
+ * @def LEADERBOARD_SIZE
+ * @brief Number of entries kept in the leaderboard.
  */
-int loadHighScore();
-
-extern Game *tetg;
-
-// MEMORY FREE
+#define LEADERBOARD_SIZE 10
 
 /**
- * @brief Frees all memory allocated for the game, including the game structure,
- * field, figures, templates, and player.
- * @param tetg: A pointer to the game structure to be freed.
+ * @def SCORE_NAME_SIZE
+ * @brief Size of a player name in the leaderboard, including the terminator.
  */
-void freeGame(Game *tetg);
+#define SCORE_NAME_SIZE 16
 
 /**
- * @brief Frees all memory allocated for the field structure, including the
- * blocks within the field.
- * @param tetf: A pointer to the field structure to be freed.
+ * @struct ScoreEntry
+ * @brief One line of the leaderboard.
  */
-void freeField(Field *tetf);
+typedef struct ScoreEntry {
+  char name[SCORE_NAME_SIZE];
+  int32_t score;
+  int32_t level;
+  int64_t date;
+} ScoreEntry;
 
 /**
- * @brief Frees the memory allocated for a figure, including its blocks.
- * @param tf: A pointer to the figure to be freed.
+ * @struct Leaderboard
+ * @brief The best LEADERBOARD_SIZE games, highest score first.
  */
-void freeFigure(Figure *tf);
+typedef struct Leaderboard {
+  int count;
+  ScoreEntry entries[LEADERBOARD_SIZE];
+} Leaderboard;
 
 /**
- * @brief Frees the memory allocated for the FiguresT structure.
- * @param tetft: A pointer to the FiguresT structure to be freed.
+ * @brief Inserts a finished game into the leaderboard if it ranks.
+ * @param board: Leaderboard to update.
+ * @param name: Player name, truncated to SCORE_NAME_SIZE - 1 characters.
+ * @param score: Final score.
+ * @param level: Final level.
+ * @param date: Time the game ended.
+ * @return Rank of the new entry starting at 0, or -1 if it did not rank.
  */
-void freeFiguresT(FiguresT *tetft);
+int submitScore(Leaderboard *board, const char *name, int score, int level,
+                time_t date);
 
 /**
- * @brief Frees the memory allocated for block templates.
- * @param templates: A pointer to the array of block templates to be freed.
+ * @brief Saves the leaderboard to a file. The data is written to a temporary
+ * file, synced and renamed over the old one, so a crash leaves either the old
+ * or the new leaderboard. Called by the frontend when a game ends, never from
+ * the game tick.
+ * @param board: Leaderboard to save.
+ * @param path: Destination file.
+ * @return 0 on success, -1 on failure.
  */
-void freeTemplates(Block **templates);
+int saveHighScore(const Leaderboard *board, const char *path);
 
 /**
- * @brief Frees the memory allocated for a print field array.
- * @param print_field: A pointer to the print field array to be freed.
- * @param height: The number of rows in the print field array.
+ * @brief Loads the leaderboard from a file once at startup. A missing or
+ * unreadable file gives an empty leaderboard; a file holding a single number
+ * (the old format) becomes one entry.
+ * @param board: Receives the leaderboard.
+ * @param path: File to read.
+ * @return The high score, 0 for an empty leaderboard.
  */
-void freePrintField(int **print_field, int height);
+int loadHighScore(Leaderboard *board, const char *path);
 
-/**
- * @brief Frees the memory allocated for the next block array.
- * @param next: A pointer to the next block array to be freed.
- * @param size: The number of rows in the next block array.
- */
-void freeNextBlock(int **next, int size);
+// MEMORY FREE
 
 /**
- * @brief Frees the GUI-related structures, including the print field and next
- * block.
- * @param game: A structure containing GUI-related data.
- * @param size: The size parameter used for freeing the next block.
- * @param height: The height parameter used for freeing the print field.
+ * @brief Frees a game made by initGame(), createGame() or cloneGame(). The
+ * whole game is one block, so this is a single free().
+ * @param tetg: A pointer to the game structure to be freed.
  */
-void freeGui(GameInfo_t game, int size, int height);
+void freeGame(Game *tetg);
 
 #endif
\ No newline at end of file
@@ -1,5 +1,33 @@
 #include "cli.h"
 
+#include <string.h>
+
+/**
+ * Screen attribute of every cell value, indexed by piece id (0 is empty).
+ * Built once by initGui() so drawing a run is a single attrset().
+ */
+static attr_t field_attrs[PIECE_IDS];
+static attr_t next_attrs[PIECE_IDS];
+
+/**
+ * Text of a run of cells, indexed by piece id like the attributes: blanks
+ * in the piece's color, or brackets for a piece drawn in a borrowed color.
+ */
+static const char *cell_runs[PIECE_IDS];
+static const char blank_run[] = "                    ";
+static const char bracket_run[] = "[][][][][][][][][][]";
+
+/**
+ * Background color of each piece, by template index (i o t s z j l). The
+ * field is yellow and the preview box black, so neither is used; L takes
+ * bright red where the terminal has 16 colors. With 8 colors it is drawn as
+ * black brackets on white, which tells it apart from the plain white O.
+ */
+#define COLOR_BRIGHT_RED (COLOR_RED + 8)
+static const short piece_colors[PIECE_IDS - 1] = {
+    COLOR_CYAN, COLOR_WHITE, COLOR_MAGENTA,   COLOR_GREEN,
+    COLOR_RED,  COLOR_BLUE,  COLOR_BRIGHT_RED};
+
 void initGui() {
   initscr();
   curs_set(0);
@@ -8,13 +36,38 @@ void initGui() {
   init_pair(2, COLOR_GREEN, COLOR_GREEN);
   init_pair(3, COLOR_YELLOW, COLOR_BLACK);
   init_pair(4, COLOR_GREEN, COLOR_BLACK);
+  field_attrs[0] = COLOR_PAIR(1);
+  next_attrs[0] = COLOR_PAIR(0);
+  cell_runs[0] = blank_run;
+  for (int id = 1; id < PIECE_IDS; id++) {
+    short color = piece_colors[id - 1];
+    cell_runs[id] = blank_run;
+    if (color >= COLORS) {
+      init_pair(PIECE_PAIR + id, COLOR_BLACK, COLOR_WHITE);
+      cell_runs[id] = bracket_run;
+    } else {
+      init_pair(PIECE_PAIR + id, color, color);
+    }
+    field_attrs[id] = next_attrs[id] = COLOR_PAIR(PIECE_PAIR + id);
+  }
 
   cbreak();
   noecho();
   nodelay(stdscr, TRUE);
   scrollok(stdscr, TRUE);
+
+  resetScreenCache();
+  printChrome();
 }
 
+/**
+ * Last frame written to the screen, used to emit only the cells and values
+ * that changed. -1 marks a cell that has to be drawn.
+ */
+static int drawn_field[FIELD_ROWS][FIELD_COLS];
+static int drawn_next[NEXT_SIZE][NEXT_SIZE];
+static GameInfo_t drawn_info;
+
 void printGame(GameInfo_t game, struct timespec sp_start,
                struct timespec sp_end) {
   printField(game);
@@ -23,48 +76,116 @@ void printGame(GameInfo_t game, struct timespec sp_start,
 
   printInfo(game);
 
-  freeGui(game, 5, 20);
   handleDelay(sp_start, sp_end, game.speed);
   refresh();
 }
 
-void printField(GameInfo_t game) {
-  for (int i = 0; i < 20; i++) {
-    for (int j = 0; j < 10; j++) {
-      int sym = game.field[i][j] != 0 ? 2 : 1;
-      attron(COLOR_PAIR(sym));
-      mvaddch(i + 3, j * 2 + 2, ' ');
-      mvaddch(i + 3, j * 2 + 3, ' ');
-      attroff(COLOR_PAIR(sym));
+void drawGame(GameInfo_t game) {
+  printField(game);
+
+  printNextFigure(game);
+
+  printInfo(game);
+
+  refresh();
+}
+
+void resetScreenCache() {
+  for (int i = 0; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLS; j++) drawn_field[i][j] = -1;
+  for (int i = 0; i < NEXT_SIZE; i++)
+    for (int j = 0; j < NEXT_SIZE; j++) drawn_next[i][j] = -1;
+  drawn_info = (GameInfo_t){.level = -1, .speed = -1, .score = -1,
+                            .high_score = -1, .pause = -1};
+}
+
+/**
+ * Draws the changed cells of one row, two screen columns per cell, as runs of
+ * cells of the same piece written with a single string each.
+ */
+static void printCellRow(int *drawn, const uint8_t *cells, int count, int y,
+                         int x, const attr_t *attrs) {
+  int j = 0, drew = 0;
+  while (j < count) {
+    int id = cells[j] < PIECE_IDS ? cells[j] : 1;
+    if (drawn[j] == id) {
+      j++;
+      continue;
     }
+    int run = j;
+    while (run < count && cells[run] == cells[j] && drawn[run] != id)
+      drawn[run++] = id;
+    attrset(attrs[id]);
+    mvaddnstr(y, x + j * 2, cell_runs[id], (run - j) * 2);
+    drew = 1;
+    j = run;
   }
+  if (drew) attrset(A_NORMAL);
 }
 
-void printNextFigure(GameInfo_t game) {
-  for (int i = 0; i < 5; i++) {
-    for (int j = 0; j < 5; j++) {
-      int sym = game.next[i][j] != 0 ? 2 : 0;
-      attron(COLOR_PAIR(sym));
-      mvaddch(i + 5, j * 2 + 28, ' ');
-      mvaddch(i + 5, j * 2 + 29, ' ');
-      attroff(COLOR_PAIR(sym));
-    }
+/**
+ * Draws the field from one pointer per row.
+ */
+static void printFieldRows(const uint8_t *const *rows, int pause) {
+  if (!pause && drawn_info.pause == 1)  // uncover the field row
+    for (int j = 0; j < FIELD_COLS; j++) drawn_field[PAUSE_ROW][j] = -1;
+  for (int i = 0; i < FIELD_ROWS; i++)
+    printCellRow(drawn_field[i], rows[i], FIELD_COLS, i + 3, 2, field_attrs);
+}
+
+void printField(GameInfo_t game) {
+  printFieldRows((const uint8_t *const *)game.field, game.pause);
+}
+
+void drawView(const GameView *view) {
+  const Shape *shape = view->shape;
+  int top = view->piece.y + shape->dy, left = view->piece.x + shape->dx;
+  int id = view->piece.type + 1;
+  const uint8_t *rows[FIELD_ROWS];
+  uint8_t piece_rows[4][FIELD_COLS];
+
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    rows[i] = view->cells + i * view->width;
+    int y = i - top;
+    if (y < 0 || y >= shape->h) continue;  // the engine's row as it is
+    memcpy(piece_rows[y], rows[i], FIELD_COLS);
+    for (int x = 0; x < shape->w; x++)
+      if (((shape->rows[y] >> x) & 1) && left + x >= 0 && left + x < FIELD_COLS)
+        piece_rows[y][left + x] = (uint8_t)id;
+    rows[i] = piece_rows[y];
   }
+  printFieldRows(rows, view->pause);
+
+  const Shape *next = view->next_shape;
+  for (int i = 0; i < NEXT_SIZE; i++) {
+    uint8_t cells[NEXT_SIZE] = {0};
+    int y = i - next->dy;
+    for (int x = 0; y >= 0 && y < next->h && x < next->w; x++)
+      if ((next->rows[y] >> x) & 1) cells[next->dx + x] = (uint8_t)(view->next + 1);
+    printCellRow(drawn_next[i], cells, NEXT_SIZE, i + 5, 28, next_attrs);
+  }
+
+  printInfo((GameInfo_t){.score = view->score,
+                         .high_score = view->high_score,
+                         .level = view->level,
+                         .speed = view->speed,
+                         .pause = view->pause});
+  refresh();
 }
 
-void printInfo(GameInfo_t game) {
+void printNextFigure(GameInfo_t game) {
+  for (int i = 0; i < NEXT_SIZE; i++)
+    printCellRow(drawn_next[i], game.next[i], NEXT_SIZE, i + 5, 28,
+                 next_attrs);
+}
+
+void printChrome() {
   attron(COLOR_PAIR(3));
   mvwprintw(stdscr, 1, 10, "TETRIS");
   attroff(COLOR_PAIR(3));
 
   attron(COLOR_PAIR(4));
   mvwprintw(stdscr, 3, 26, "Next figure:");
-  mvwprintw(stdscr, 11, 26, "Lvl: %d", game.level);
-  mvwprintw(stdscr, 13, 26, "Speed: %d", game.speed);
-  mvwprintw(stdscr, 15, 26, "Score: %d", game.score);
-  clrtoeol();
-  mvwprintw(stdscr, 17, 26, "High score: %d", game.high_score);
-  if (game.pause) mvwprintw(stdscr, 12, 2, "Press ENTER to play.");
   attroff(COLOR_PAIR(4));
   attron(COLOR_PAIR(5));
   mvwprintw(stdscr, 24, 6, "Press:");
@@ -74,11 +195,40 @@ void printInfo(GameInfo_t game) {
   mvwprintw(stdscr, 27, 14, "Arrows to move: '<' '>'");
   mvwprintw(stdscr, 28, 14, "Space to rotate: '___'");
   mvwprintw(stdscr, 29, 14, "Arrow down to plant: 'v'");
+  mvwprintw(stdscr, 30, 14, "Arrow up to drop: '^'");
   attroff(COLOR_PAIR(5));
 }
 
-UserAction_t getAction() {
-  int ch = getch();
+void printInfo(GameInfo_t game) {
+  attron(COLOR_PAIR(4));
+  if (game.level != drawn_info.level) {  // a rewind can lower it
+    mvwprintw(stdscr, 11, 26, "Lvl: %d", game.level);
+    clrtoeol();
+  }
+  if (game.speed != drawn_info.speed) {
+    mvwprintw(stdscr, 13, 26, "Speed: %d", game.speed);
+    clrtoeol();
+  }
+  if (game.score != drawn_info.score) {
+    mvwprintw(stdscr, 15, 26, "Score: %d", game.score);
+    clrtoeol();
+  }
+  if (game.high_score != drawn_info.high_score)
+    mvwprintw(stdscr, 17, 26, "High score: %d", game.high_score);
+  if (game.pause && game.pause != drawn_info.pause)
+    mvwprintw(stdscr, 12, 2, "Press ENTER to play.");
+  attroff(COLOR_PAIR(4));
+  drawn_info = game;
+}
+
+UserAction_t getAction() { return keyAction(getch()); }
+
+int readKey(int *ch) {
+  *ch = getch();
+  return *ch != ERR;
+}
+
+UserAction_t keyAction(int ch) {
   switch (ch) {
     case 68:
       return Left;
@@ -88,6 +238,8 @@ UserAction_t getAction() {
       return Up;
     case 66:
       return Down;
+    case 65:
+      return HardDrop;
     case '\n':
       return Start;
     case 'p':
@@ -99,13 +251,24 @@ UserAction_t getAction() {
   }
 }
 
+FrontendKey_t frontendKeyOf(int ch) {
+  switch (ch) {
+    case 's':
+      return DumpStatsKey;
+    case 'r':
+      return RewindKey;
+    default:
+      return NoFrontendKey;
+  }
+}
+
+long framePeriodNs(int game_speed) { return 20000000L - game_speed * 1500000L; }
+
 void handleDelay(struct timespec sp_start, struct timespec sp_end,
                  int game_speed) {
   clock_gettime(CLOCK_MONOTONIC, &sp_end);
-  struct timespec ts1, ts2 = {0, 0};
-  if (sp_end.tv_sec - sp_start.tv_sec <= 0 &&
-      (ts2.tv_nsec = (20000000 - game_speed * 1500000) -
-                     (sp_end.tv_nsec - sp_start.tv_nsec)) > 0) {
-    nanosleep(&ts2, &ts1);
-  }
-}
\ No newline at end of file
+  long elapsed = (sp_end.tv_sec - sp_start.tv_sec) * 1000000000L +
+                 (sp_end.tv_nsec - sp_start.tv_nsec);
+  struct timespec ts = {0, framePeriodNs(game_speed) - elapsed};
+  if (ts.tv_nsec > 0) nanosleep(&ts, NULL);
+}
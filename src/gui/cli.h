@@ -4,6 +4,24 @@
 
 #include "../brick_game/tetris.h"
 
+#define FIELD_ROWS 20
+#define FIELD_COLS 10
+#define NEXT_SIZE 5
+#define PAUSE_ROW 9  // field row covered by the pause message
+#define PIECE_IDS 8   // cell values: empty and the seven pieces
+#define PIECE_PAIR 8  // color pair of piece id k is PIECE_PAIR + k
+#define FRONTEND_KEYS 3  // FrontendKey_t values
+
+/**
+ * @enum FrontendKey_t
+ * @brief Keys that act on the frontend rather than on the game.
+ */
+typedef enum {
+  NoFrontendKey,
+  DumpStatsKey,  ///< write the frame timing report
+  RewindKey      ///< take back the last piece
+} FrontendKey_t;
+
 /**
  * @brief Initializes the graphical user interface for the game. This function
  * sets up the terminal for displaying the game, initializes color pairs, and
@@ -12,9 +30,10 @@
 void initGui();
 
 /**
- * @brief Prints the entire game state to the screen, including the game field,
- * the next figure, and game information like score and level. It also refreshes
- * the screen to update the display.
+ * @brief Prints the game state to the screen, including the game field, the
+ * next figure, and game information like score and level. Only what changed
+ * since the previous frame is written. It also refreshes the screen to update
+ * the display.
  * @param game: The current game state containing field, next figure, and game
  * @param sp_start Time of starting loop.
  * @param sp_end Time of ending loop.
@@ -24,13 +43,24 @@ void printGame(GameInfo_t game, struct timespec sp_start,
                struct timespec sp_end);
 
 /**
- * @brief Displays the game field on the screen. It iterates through each cell
- * of the game field and prints a space character with a color based on the
- * cell's state.
+ * @brief Displays the game field on the screen. Cells that differ from the
+ * previous frame are written as runs of equally colored spaces, one string
+ * per run, in the color of the piece that filled them.
  * @param game: The current game state containing the field to be displayed.
  */
 void printField(GameInfo_t game);
 
+/**
+ * @brief Forgets what is on the screen so the next frame is drawn in full.
+ */
+void resetScreenCache();
+
+/**
+ * @brief Draws the parts of the screen that never change: the title, the
+ * labels and the help block.
+ */
+void printChrome();
+
 /**
  * @brief Displays the next figure on the screen in a designated area. It uses a
  * different color to distinguish the next figure from the game field.
@@ -41,12 +71,27 @@ void printNextFigure(GameInfo_t game);
 
 /**
  * @brief Prints game-related information such as the current level, speed,
- * score, and high score. It also displays controls and game status (e.g.,
- * paused) to the player.
+ * score, and high score, and the pause message, each only when its value
+ * changed.
  * @param game: The current game state containing information to be displayed.
  */
 void printInfo(GameInfo_t game);
 
+/**
+ * @brief Prints the game state like printGame() but refreshes the screen
+ * right away instead of sleeping first.
+ * @param game: The current game state.
+ */
+void drawGame(GameInfo_t game);
+
+/**
+ * @brief Draws a game straight from the engine's storage, without the
+ * output buffers of exportCurrentState(). Only the rows the falling figure
+ * covers are copied to draw it over the field.
+ * @param view: View of the game, see viewGame().
+ */
+void drawView(const GameView *view);
+
 /**
  * @brief Reads a single character from the keyboard input and returns an action
  * based on the key pressed. Actions include moving the figure in different
@@ -55,6 +100,34 @@ void printInfo(GameInfo_t game);
  */
 UserAction_t getAction();
 
+/**
+ * @brief Maps a key code to the action it triggers.
+ * @param ch: Key code as returned by getch().
+ * @return The matching action, or Action for keys without one.
+ */
+UserAction_t keyAction(int ch);
+
+/**
+ * @brief Maps a key code to the frontend command it triggers.
+ * @param ch: Key code as returned by getch().
+ * @return The matching command, or NoFrontendKey for game keys.
+ */
+FrontendKey_t frontendKeyOf(int ch);
+
+/**
+ * @brief Reads one pending key without waiting.
+ * @param ch: Receives the key code.
+ * @return 1 if a key was read, 0 if no input is pending.
+ */
+int readKey(int *ch);
+
+/**
+ * @brief Returns the frame period the game runs at for a given speed.
+ * @param game_speed: Current speed of the game.
+ * @return Frame period in nanoseconds.
+ */
+long framePeriodNs(int game_speed);
+
 /**
  * @brief Calculates and executes a delay based on the game speed and the time
  * taken to execute the last frame.
@@ -0,0 +1,96 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../brick_game/simulation.h"
+
+#define MAX_THREADS 256
+
+/**
+ * Per-thread state. Each worker only writes its own slot, aligned to a cache
+ * line so neighbours never share one; results are merged after the join.
+ */
+typedef struct Worker {
+  _Alignas(64) pthread_t thread;
+  int id;
+  int threads;
+  long games;
+  long max_frames;
+  uint64_t seed;
+  bool bag;
+  const char *script;
+  BatchStats stats;
+  bool started;  ///< false: the shard runs on the main thread
+  bool failed;
+} Worker;
+
+static void *runWorker(void *arg) {
+  Worker *w = (Worker *)arg;
+  for (long g = w->id; g < w->games; g += w->threads) {
+    GameResult result;
+    if (simulateGame(w->script, w->seed + (uint64_t)g, w->bag, w->max_frames,
+                     &result) != 0) {
+      w->failed = true;
+      break;
+    }
+    addGameResult(&w->stats, &result);
+  }
+  return NULL;
+}
+
+static void printStat(const char *name, const StatRange *range, long games) {
+  printf("  %-8s mean %12.1f  min %10ld  max %10ld\n", name,
+         (double)range->sum / games, range->min, range->max);
+}
+
+int main(int argc, char **argv) {
+  long games = argc > 1 ? atol(argv[1]) : 10000;
+  int threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+  bool bag = argc > 4 && atoi(argv[4]);
+  const char *script = argc > 5 ? argv[5] : NULL;
+  long max_frames = 1000000;
+  static Worker workers[MAX_THREADS];
+  BatchStats total = {0};
+
+  if (threads < 1) threads = 1;
+  if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+  double start = monotonicSeconds();
+  for (int i = 0; i < threads; i++) {
+    workers[i] = (Worker){.id = i,
+                          .threads = threads,
+                          .games = games,
+                          .max_frames = max_frames,
+                          .seed = seed,
+                          .bag = bag,
+                          .script = script};
+    workers[i].started =
+        pthread_create(&workers[i].thread, NULL, runWorker, &workers[i]) == 0;
+  }
+  bool failed = false;
+  for (int i = 0; i < threads; i++) {
+    if (workers[i].started)
+      pthread_join(workers[i].thread, NULL);
+    else
+      runWorker(&workers[i]);
+    mergeBatchStats(&total, &workers[i].stats);
+    failed |= workers[i].failed;
+  }
+  double seconds = monotonicSeconds() - start;
+  if (failed) {
+    fprintf(stderr, "batch: out of memory\n");
+    return 1;
+  }
+
+  printf("batch: %ld games on %d threads in %.3f s (%.0f games/sec, %.0f "
+         "frames/sec)\n",
+         total.games, threads, seconds, total.games / seconds,
+         total.frames.sum / seconds);
+  if (total.games == 0) return 0;
+  printStat("score", &total.score, total.games);
+  printStat("level", &total.level, total.games);
+  printStat("lines", &total.lines, total.games);
+  printStat("pieces", &total.pieces, total.games);
+  printStat("frames", &total.frames, total.games);
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include <string.h>
+
+#include "../brick_game/placement.h"
+#include "../brick_game/simulation.h"
+
+#define MICRO_ITERATIONS 2000000L
+#define SEARCH_ITERATIONS 20000L  // a placement search takes microseconds
+
+static volatile long sink;
+static PlacementSearch *search;
+static Game *erase_start;  // field restored before every eraseLines call
+
+/**
+ * Runs fn the given number of times on the game and prints ns per call.
+ */
+static void micro(const char *name, Game *tetg, void (*fn)(Game *),
+                  long iterations) {
+  double start = monotonicSeconds();
+  for (long i = 0; i < iterations; i++) fn(tetg);
+  double ns = (monotonicSeconds() - start) * 1e9 / iterations;
+  printf("  %-16s %8.1f ns/op\n", name, ns);
+}
+
+static void benchCollision(Game *tetg) { sink += collision(tetg); }
+
+static void benchRotFigure(Game *tetg) { rotFigure(tetg, 1); }
+
+static void benchPlantFigure(Game *tetg) { plantFigure(tetg); }
+
+static void benchEraseLines(Game *tetg) {
+  Field *field = tetg->field;
+  const Field *start = erase_start->field;
+  size_t w = (size_t)field->width, h = (size_t)field->height;
+  memcpy(field->rows, start->rows, h * sizeof(field->rows[0]));
+  memcpy(field->fill, start->fill, h);
+  memcpy(field->heights, start->heights, w);
+  memcpy(field->cells, start->cells, w * h);
+  sink += eraseLines(tetg);
+}
+
+/**
+ * Gives the game's bottom rows two full lines between two partial ones and
+ * keeps a copy of the field for benchEraseLines() to start from.
+ */
+static void setupEraseLines(Game *tetg) {
+  Field *field = tetg->field;
+  for (int i = field->height - 4; i < field->height; i++)
+    field->rows[i] = i % 2 ? field->full : 0x155;
+  recountField(field);
+  erase_start = cloneGame(tetg);
+}
+
+static void benchFillPrintField(Game *tetg) {
+  fillPrintField(tetg, tetg->print_field[0]);
+  sink += tetg->print_field[0][0][0];
+}
+
+static void benchExportCurrentState(Game *tetg) {
+  sink += exportCurrentState(tetg).field[0][0];
+}
+
+static void benchViewGame(Game *tetg) {
+  GameView view = viewGame(tetg);
+  sink += view.cells[0];
+}
+
+static void benchFindPlacements(Game *tetg) {
+  sink += findPlacements(search, tetg);
+}
+
+/**
+ * Prepares a game with some rubble at the bottom and the figure in the
+ * middle of the field.
+ */
+static Game *setupMicro() {
+  Game *tetg = initGame(1, false);
+  for (int i = tetg->field->height - 6; i < tetg->field->height; i++)
+    tetg->field->rows[i] = (uint16_t)(0x2DB >> (i % 3));
+  recountField(tetg->field);
+  tetg->figure->y = tetg->field->height / 2;
+  return tetg;
+}
+
+int main(int argc, char **argv) {
+  long frames = argc > 1 ? atol(argv[1]) : 1000000;
+  uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+  const char *script = argc > 3 ? argv[3] : NULL;
+  SimStats st;
+
+  if (simulateFrames(frames, script, seed, &st) != 0) {
+    fprintf(stderr, "bench: out of memory\n");
+    return 1;
+  }
+  printf("headless: %ld frames, %ld games, %ld pieces, %ld lines in %.3f s\n",
+         st.frames, st.games, st.pieces, st.lines, st.seconds);
+  printf("  frames/sec       %12.0f\n", st.frames / st.seconds);
+  printf("  pieces/sec       %12.0f\n", st.pieces / st.seconds);
+  printf("  lines/sec        %12.0f\n", st.lines / st.seconds);
+
+  printf("micro (%ld iterations, %ld for searches):\n", MICRO_ITERATIONS,
+         SEARCH_ITERATIONS);
+  Game *tetg = setupMicro();
+  micro("collision", tetg, benchCollision, MICRO_ITERATIONS);
+  micro("rotFigure", tetg, benchRotFigure, MICRO_ITERATIONS);
+  micro("plantFigure", tetg, benchPlantFigure, MICRO_ITERATIONS);
+  freeGame(tetg);
+  tetg = setupMicro();
+  setupEraseLines(tetg);
+  micro("eraseLines", tetg, benchEraseLines, MICRO_ITERATIONS);
+  freeGame(erase_start);
+  micro("fillPrintField", tetg, benchFillPrintField, MICRO_ITERATIONS);
+  micro("exportState", tetg, benchExportCurrentState, MICRO_ITERATIONS);
+  micro("viewGame", tetg, benchViewGame, MICRO_ITERATIONS);
+  search = createPlacementSearch(tetg->field->width, tetg->field->height);
+  micro("findPlacements", tetg, benchFindPlacements, SEARCH_ITERATIONS);
+  freePlacementSearch(search);
+  freeGame(tetg);
+  return 0;
+}
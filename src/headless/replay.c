@@ -0,0 +1,22 @@
+#include "../brick_game/replay.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s replay-file...\n", argv[0]);
+    return 1;
+  }
+  for (int i = 1; i < argc; i++) {
+    GameResult r;
+    double start = monotonicSeconds();
+    if (replayGame(argv[i], &r) != 0) {
+      fprintf(stderr, "%s: not a replay file\n", argv[i]);
+      return 1;
+    }
+    double seconds = monotonicSeconds() - start;
+    printf("%s: score %ld, level %ld, lines %ld, pieces %ld, frames %ld "
+           "(%.0f frames/sec)\n",
+           argv[i], r.score, r.level, r.lines, r.pieces, r.frames,
+           r.frames / (seconds > 0 ? seconds : 1e-9));
+  }
+  return 0;
+}